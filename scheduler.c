@@ -1,25 +1,52 @@
+// POSIX.1-2008 for getline, fseeko, mkstemp, strdup and posix_madvise, also under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/resource.h>
 
+#include "scheduler.h"
 
-#define MAX_INSTRUCTIONS 100
-#define INT_MAX 100000
 
-// The process structure
-// Type enumeration: 1 for plat, 2 for gold, 3 for silver
-typedef struct {
-    int id;
-    int priority;
-    int arrival_time;
-    int remaining_time;
-    int burst_time;
-    int instruction_index;
-    int type;
-    int completed;  // Flag to indicate whether the process is completed
-    int instructions[MAX_INSTRUCTIONS];
-} Process;
+
+// Binary trace format, see writeTraceFile for the layout
+#define TRACE_MAGIC "SCHDTRC"
+#define TRACE_VERSION 1
+#define TRACE_BYTE_ORDER 0x01020304u
+
+// Most CPUs a multi-CPU run simulates
+#define MAX_CPUS 1024
+
+// Highest instrN and PX id; instructions and programs live in tables indexed by id
+#define MAX_ID (1 << 24)
+
+// Snapshot format, see takeCheckpoint for the layout
+#define CHECKPOINT_MAGIC "SCHDCKP"
+#define CHECKPOINT_VERSION 1
+
+// Hot-path counters; with -DSCHEDULER_NO_PROFILE they compile to nothing and amount is not evaluated
+#ifdef SCHEDULER_NO_PROFILE
+#define PROFILE_COUNT(counter, amount) ((void)sizeof((counter) += (amount)))
+#else
+#define PROFILE_COUNT(counter, amount) ((counter) += (amount))
+#endif
+
+// Number of policy constants a sweep can vary (fields of PolicyConfig); the policy itself is the last
+#define SWEEP_PARAMETERS 8
+#define SWEEP_POLICY 7
 
 // Instruction structure from instruction.txt
 typedef struct {
@@ -27,538 +54,5672 @@ typedef struct {
     int burst_time;
 } Instruction;
 
-int inputNumber = 1;
-// Prototypes
-int readInstructionsFromFile(const char *filename, Instruction instructions[]);
-int readInstructionsForProcessesFromFile(const char *filename, int instructionIds[]);
-int readProcessesFromFile(const char *filename, Process processes[]);
-void preemptivePriorityScheduling(Process allProcesses[], Process processes[], int num_processes);
-void calculateAverages(int turnaroundTimes[], int waitingTimes[], int num_processes);
-Instruction* getInstructionById(int targetId, Instruction instructions[], int numInstructions);
+// Growable table of instructions, grown like ProcessTable
+typedef struct {
+    Instruction *items;
+    int count;
+    int capacity;
+} InstructionTable;
 
+// Instruction catalog compiled into a table indexed directly by instruction id
+typedef struct {
+    int *burst_by_id;  // -1 for ids missing from instructions.txt
+    int max_id;
+    int exit_burst;
+} InstructionCatalog;
 
-// Function to get an instruction by ID
-Instruction* getInstructionById(int targetId, Instruction instructions[], int numInstructions) {
-    for (int i = 0; i < numInstructions; i++) {
-        if (instructions[i].id == targetId) {
-            // Return a pointer to the matching instruction
-            return &instructions[i];
-        }
-    }
+// Cursor over a mapped file; line and line_start locate errors as file:line:column
+typedef struct {
+    const char *pos;
+    const char *end;
+    const char *line_start;
+    int line;
+    const char *filename;
+} Tokenizer;
 
-    // If no matching ID is found, return NULL
-    return NULL;
-}
+// Binary trace header, followed by 8-byte aligned arrays of int32 values
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;  // TRACE_BYTE_ORDER as written by the producer
+    uint32_t num_processes;
+    uint32_t num_programs;
+    uint32_t pool_count;
+    uint32_t reserved;
+} TraceHeader;
 
-// Function to read instructions from file and create Instruction structures
-int readInstructionsFromFile(const char *filename, Instruction instructions[]) {
-    FILE *file = fopen(filename, "r");
+// Snapshot header: the clock, the input position and the result totals of a run, followed by
+// its live processes, free slots, read-ahead ring, ready queues, CPUs and statistics
+// Snapshots are raw memory and only resume on a build with the same byte order and Process layout
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t process_size;
+    int32_t time;
+    int32_t num_cpus;
+    int32_t balance;
+    int32_t streamed;
+    int32_t live;
+    int32_t last_run;         // single-CPU engine only
+    int32_t num_definitions;  // batch: definitions of the workload, before the first next_arrival are admitted
+    int32_t next_arrival;
+    int32_t num_slots;        // stream: slots handed out, num_free of them free
+    int32_t num_free;
+    int32_t num_read;
+    int32_t line;
+    int32_t last_arrival;
+    int32_t exhausted;
+    int32_t num_pending;
+    int32_t num_live_processes;
+    int32_t num_queues;
+    int32_t per_process;
+    int32_t num_cores;
+    int32_t peak_live;
+    int32_t makespan;
+    int32_t reserved;
+    int64_t input_offset;     // stream: position of the next unread line
+    int64_t num_completed;
+    int64_t total_turnaround;
+    int64_t total_waiting;
+    int64_t total_response;
+    int64_t total_context_switches;
+    int64_t num_dispatches;
+    int64_t migrations;
+    int64_t deadline_misses;
+} CheckpointHeader;
 
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1; // Return -1 on failure
-    }
+// Growable byte buffer a snapshot is serialized into
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} CheckpointBuffer;
 
-    int count = 0;
-    while (count < MAX_INSTRUCTIONS && fscanf(file, "instr%d %d\n", &instructions[count].id, &instructions[count].burst_time) == 2) {
-        count++;
-    }
+// Values of one sweep option, e.g. --silver-quantum 60,80,100
+typedef struct {
+    int *values;
+    int count;
+    int capacity;
+} IntList;
 
-    // Check for "exit" instruction
-    if (fscanf(file, "exit %d\n", &instructions[count].burst_time) == 1) {
-        instructions[count].id = -1; // Use a special id (e.g., -1) to represent "exit"
-        count++;
-    }
+// Shared state of a parameter sweep; workers claim configurations through next
+typedef struct {
+    const Workload *workload;
+    const PolicyConfig *configs;
+    ScheduleAverages *results;
+    int num_configs;
+    atomic_int next;
+    atomic_int failed;
+} SweepJob;
 
-    fclose(file);
-    return count; // Return the number of instructions read
-}
+// Shared state of a batch of definition files scheduled against one program library
+typedef struct {
+    const Workload *library;
+    const char *const *paths;
+    const PolicyConfig *config;
+    BatchResult *results;
+    int num_paths;
+    atomic_int next;
+    atomic_int failed;
+} BatchJob;
 
-// Function to read instructions from file for each process
-int readInstructionsForProcessesFromFile(const char *filename, int instructionIds[]) {
-    FILE *file = fopen(filename, "r");
+// Values kept per replication: average, p50, p95, p99 of waiting, then of turnaround
+#define REPLICATION_METRICS 8
 
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1; // Return -1 on failure
-    }
+// Shared state of a replication run; workers claim replications through next
+typedef struct {
+    const Workload *workload;
+    const PolicyConfig *policy;
+    const ReplicationConfig *config;
+    double *metrics;      // REPLICATION_METRICS values per replication
+    atomic_int next;
+    atomic_int failed;
+} ReplicationJob;
 
-    int count = 0;
-    while (fscanf(file, "instr%d\n", &instructionIds[count]) == 1 && count < MAX_INSTRUCTIONS) {
-        count++;
-    }
+// Phases of loading program files; the parallel ones run on a thread pool, one program at a time
+enum { PROGRAM_MAP, PROGRAM_PARSE };
 
-    // Check for "exit" instruction
-    if (fscanf(file, "exit\n") == 1) {
-        instructionIds[count] = -1; // Use a special id (e.g., -1) to represent "exit"
-        count++;
-    }
+// Shared state of loading the program files of a directory
+// Each file is mapped and hashed, files of equal content are parsed once into a private pool
+// by their first program (the representative), then every pool is copied into the workload's
+typedef struct {
+    const InstructionCatalog *catalog;
+    const char *directory;
+    const char *wanted;
+    int num_programs;
+    int num_threads;
+    int phase;
+    MappedFile *files;
+    uint64_t *hashes;
+    int *representative;      // program whose parse program i shares, i itself when it is parsed
+    InstructionPool *pools;   // private pool of each representative
+    int *bursts;
+    atomic_int next;
+    atomic_int failed;
+} ProgramLoadJob;
 
-    fclose(file);
-    return count;
-}
+// Children per heap node
+#define HEAP_ARITY 4
 
-// Function to read incoming processes from file and create Process structures
-int readProcessesFromFile(const char *filename, Process processes[]) {
-    FILE *file = fopen(filename, "r");
+// 4-ary heap of the queued processes of one type, struct of arrays: each entry carries its
+// own ordering keys so sifting never reads the Process array, and the children of a node
+// are adjacent in every array
+typedef struct {
+    long long *key;  // smaller first, then lower sequence
+    long *sequence;
+    int *index;      // slot of the process in the context
+    int size;
+} ProcessHeap;
 
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1; // Return -1 on failure
-    }
+// Virtual runtime units charged per ms to a process of priority 1 under POLICY_CFS
+#define CFS_WEIGHT_SCALE 1000
 
-    int count = 0;
+// A scheduling policy as hooks of the engines, which stay policy-free
+// A queue has three classes; the policy puts every process in one of them under an ordering key
+// Classes below strict_classes are served strictly in order, the others compete by key
+// Policy state lives in the Process, so processes can move between per-CPU queues
+typedef struct {
+    const char *name;
+    int strict_classes;
+    // optional: sets up the state of an admitted process; floor is the key last dispatched from its queue
+    void (*on_arrival)(Process *process, long long floor, const PolicyConfig *config);
+    void (*queue_key)(const Process *process, const PolicyConfig *config, int *queueClass, long long *key);
+    // ms the process may run before its quantum expires, INT_MAX to run to completion
+    int (*quantum)(const Process *process, const PolicyConfig *config);
+    // whether the arrival a, possibly not admitted yet, preempts the running process b
+    int (*preempts)(const Process *a, const Process *b, const PolicyConfig *config);
+    // optional: accounting after a slice that did not complete the process (aging, virtual runtime)
+    void (*on_slice_end)(Process *process, int slice, const PolicyConfig *config);
+} SchedulingPolicy;
 
-    // Assuming that the file format is: ID PRIORITY ARRIVAL_TIME TYPE
-    while (fscanf(file, "P%d %d %d", &processes[count].id, &processes[count].priority, &processes[count].arrival_time) == 3) {
-        // Extract the last part (type) separately
-        char type_str[20];
-        if (fscanf(file, " %s", type_str) != 1) {
-            fclose(file);
-            return -1;
-        }
+// Ready queue: one indexed heap per policy class
+// position[i] is the heap slot of process i (-1 when not queued), sequence[i] its FIFO order for round robin
+// buffers hold capacity processes and are kept between runs
+typedef struct {
+    ProcessHeap classes[3];
+    int *position;
+    long *sequence;
+    long nextSequence;
+    int capacity;
+    Process *processes;
+    const SchedulingPolicy *policy;
+    const PolicyConfig *config;
+    long long floor;  // key of the last process dispatched
+    long selections;  // profile counters, see ProfileCounters
+    long pushes;
+    long pops;
+} ReadyQueue;
 
-        // Convert type string to type enumeration
-        if (strcmp(type_str, "PLATINUM") == 0) {
-            processes[count].type = 1;
-        } else if (strcmp(type_str, "GOLD") == 0) {
-            processes[count].type = 2;
-        } else if (strcmp(type_str, "SILVER") == 0) {
-            processes[count].type = 3;
-        } else {
-            fclose(file);
-            return -1;
-        }
+// Scheduling events; the order matches the names used by the exports
+enum {
+    EVENT_ARRIVAL,
+    EVENT_CONTEXT_SWITCH,
+    EVENT_DISPATCH,         // one CPU slice: time is its start, duration its length
+    EVENT_QUANTUM_EXPIRED,
+    EVENT_PREEMPT,
+    EVENT_PROMOTE,          // type is the new type
+    EVENT_COMPLETE
+};
 
-        //printf("ID: %d, Priority: %d, Arrival Time: %d, Type: %d\n", processes[count].id, processes[count].priority, processes[count].arrival_time, processes[count].type);
+// Events per chunk of the recorder arena
+#define EVENT_CHUNK_SIZE 4096
 
-        int c;
-        // Read the remaining part of the line to move to the next line
-        while ((c = fgetc(file)) != '\n' && c != EOF) {}
+// One recorded event; input_index identifies the definition
+typedef struct {
+    int time;
+    int duration;
+    int input_index;
+    int id;
+    int cpu;                // -1 for arrivals
+    short kind;
+    short type;
+} ScheduleEvent;
 
-        if (c == EOF) {
-            // End of file reached
-            break;
-        }
+// Events are appended to fixed-size chunks so recording never moves earlier events
+typedef struct EventChunk {
+    struct EventChunk *next;
+    int count;
+    ScheduleEvent events[EVENT_CHUNK_SIZE];
+} EventChunk;
 
-        count++;
-    }
+// Final state of one completed process
+typedef struct {
+    int input_index;
+    int id;
+    int priority;
+    int final_type;
+    int arrival_time;
+    int burst_time;
+    int completion_time;
+    int response_time;
+    int context_switches;
+    int preemptions;
+} ProcessMetrics;
 
-    fclose(file);
-    return count; // Return the number of processes read
-}
+struct EventRecorder {
+    EventChunk *first;
+    EventChunk *current;    // chunk being filled; chunks after it are spare
+    long num_events;
+    int max_cpu;            // highest CPU seen, for naming the trace tracks
+    ProcessMetrics *metrics;
+    int num_metrics;
+    int metrics_capacity;
+    int failed;             // an allocation failed, the log is incomplete
+};
 
-// Function to calculate average turnaround time and average waiting time
-void calculateAverages(int turnaroundTimes[], int waitingTimes[], int num_processes) {
-    double avgTurnaround = 0.0;
-    double avgWaiting = 0.0;
+// One CPU of a multi-CPU run
+typedef struct {
+    int running;          // slot of the process on the CPU, -1 when idle
+    int last_run;         // slot of the process that ran last, -1 when a switch is due anyway
+    int finished;         // slot coming off the CPU at the current instant, -1 for none
+    int slice_start;      // after the context switch
+    int slice_end;
+    int quantum_expired;  // the slice ends on quantum expiry rather than completion or preemption
+    int stolen;           // the running process was taken from another CPU's queue
+    int claimed;          // an arrival already preempts this slice
+} Cpu;
 
-    for (int i = 0; i < num_processes; i++) {
-        avgTurnaround += turnaroundTimes[i];
-        avgWaiting += waitingTimes[i];
-    }
+// Scratch state of one scheduling thread, grown on demand and reused between runs
+struct SchedulerContext {
+    Process *processes;   // the run's working copy of the definitions, or the slots of live streamed processes
+    Process **arrivals;   // processes in arrival order
+    int capacity;
+    int arrivals_capacity;
+    int *free_slots;      // slots released by completed streamed processes
+    int num_free;
+    int num_slots;        // slots handed out so far in a streamed run
+    ReadyQueue readyQueue;    // the only queue of single-CPU and globally balanced runs
+    ReadyQueue *cpu_queues;   // per-CPU queues of multi-CPU runs with per-core balancing
+    int num_cpu_queues;
+    Cpu *cpus;
+    int cpus_capacity;
+    EventRecorder *recorder;  // NULL unless events are recorded
+    const char *checkpoint_prefix;  // snapshots go to <prefix>-<time>.ckpt
+    int checkpoint_interval;        // simulated ms between snapshots, 0 for none
+    int next_checkpoint;
+    CheckpointBuffer checkpoint;    // the last snapshot, owned by the writer thread while it runs
+    char checkpoint_path[PATH_MAX];
+    pthread_t checkpoint_writer;
+    int writer_active;
+    atomic_int checkpoint_failed;
+    const MappedFile *resume;       // snapshot the next run starts from, NULL to start at time 0
+};
+
+// Where the engine takes arrivals from: a batch already sorted by arrival, or a definition stream
+// Streamed definitions are read ahead into a ring only as far as preemption checks need to look
+typedef struct {
+    Process **sorted;     // batch: arrival order, consumed from next
+    int count;
+    int next;
+    FILE *input;          // stream: NULL for batch runs
+    const char *name;
+    const Workload *library;
+    int line;
+    int num_read;         // definitions read so far, the input index of the next one
+    Process *pending;     // read-ahead ring of parsed definitions
+    int pending_head;
+    int pending_count;
+    int pending_capacity;
+    int last_arrival;
+    int exhausted;
+    int failed;
+    char *line_buffer;
+    size_t line_capacity;
+} ArrivalSource;
 
-    avgTurnaround /= num_processes;
-    avgWaiting /= num_processes;
+// Prototypes
+static int reserveItems(void **items, int *capacity, int needed, size_t itemSize);
+static int mapFile(const char *filename, MappedFile *file);
+static void unmapFile(MappedFile *file);
+static void initTokenizer(Tokenizer *tok, const MappedFile *file, const char *filename);
+static int tokenizerError(const Tokenizer *tok, const char *message);
+static void skipBlanks(Tokenizer *tok);
+static int nextLine(Tokenizer *tok);
+static int endLine(Tokenizer *tok);
+static int matchKeyword(Tokenizer *tok, const char *keyword, size_t length);
+static int parseInt(Tokenizer *tok, int *value);
+static int parseField(Tokenizer *tok, int *value);
+static int parseType(Tokenizer *tok, int *type);
+static int readInstructionsFromFile(const char *filename, InstructionTable *instructions);
+static int readInstructionsForProcessesFromFile(const MappedFile *file, const char *filename, InstructionPool *pool);
+static int readProcessesFromFile(const char *filename, ProcessTable *processes);
+static int parseDefinitionLine(Tokenizer *tok, Process *process);
+static int preemptivePriorityScheduling(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+                                 const PolicyConfig *config, ScheduleResults *results);
+static void startProcess(Process *process, const Process *program);
+static int growContextSlots(SchedulerContext *context, int capacity);
+static int allocateSlot(SchedulerContext *context);
+static void releaseSlot(SchedulerContext *context, const ArrivalSource *source, int slot);
+static void recordCompletion(SchedulerContext *context, ScheduleResults *results, const ArrivalSource *source, const PolicyConfig *config,
+                      int slot, int currentTime, int cpu);
+static void resetEventRecorder(EventRecorder *recorder);
+static void recordEvent(EventRecorder *recorder, int kind, int time, int duration, const Process *process, int cpu);
+static void recordProcessMetrics(EventRecorder *recorder, const Process *process, int completion);
+static const char *typeName(int type);
+static int readStreamArrival(ArrivalSource *source);
+static const Process *peekArrival(ArrivalSource *source, int k);
+static int takeArrival(SchedulerContext *context, ArrivalSource *source, const Workload *workload);
+static int admitArrivals(SchedulerContext *context, ArrivalSource *source, const Workload *workload, int currentTime);
+static int runEngine(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+              const PolicyConfig *config, ScheduleResults *results);
+static int appendCheckpoint(CheckpointBuffer *buffer, const void *data, size_t size);
+static int readCheckpoint(const MappedFile *file, size_t *offset, void *data, size_t size);
+static ReadyQueue *engineQueue(SchedulerContext *context, const PolicyConfig *config, int q);
+static void *checkpointWriter(void *argument);
+static int finishCheckpoints(SchedulerContext *context);
+static void startCheckpoints(SchedulerContext *context, int currentTime);
+static int takeCheckpoint(SchedulerContext *context, const ArrivalSource *source, const PolicyConfig *config,
+                   const ScheduleResults *results, int currentTime, int live, int lastRun);
+static int restoreCheckpoint(SchedulerContext *context, ArrivalSource *source, const PolicyConfig *config,
+                      ScheduleResults *results, int *currentTime, int *live, int *lastRun);
+static int beginResume(SchedulerContext *context, const char *snapshot, MappedFile *file);
+static int plannedSlice(const InstructionPool *pool, const Process *running, const PolicyConfig *config, int *quantumExpired);
+static int checkSlice(const Process *running, int slice);
+static int finishSlice(const InstructionPool *pool, Process *running, int slice, const PolicyConfig *config);
+static int queuedCount(const ReadyQueue *queue);
+static int reserveCpus(SchedulerContext *context, int numCpus, int perCoreQueues);
+static int reserveCoreStats(ScheduleResults *results, int numCpus);
+static ReadyQueue *cpuQueue(SchedulerContext *context, const PolicyConfig *config, int cpu);
+static int placeArrival(SchedulerContext *context, const PolicyConfig *config, const Process *process);
+static int preemptCpu(SchedulerContext *context, const InstructionPool *pool, Cpu *cpu, int time);
+static int preemptionVictim(SchedulerContext *context, const PolicyConfig *config, const Process *arrival);
+static int takeNextProcess(SchedulerContext *context, const PolicyConfig *config, int cpu, int *stolen);
+static int smpScheduling(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+                  const PolicyConfig *config, ScheduleResults *results);
+static void calculateAverages(ScheduleResults *results);
+static int reserveScheduleResults(ScheduleResults *results, int num_processes);
+static int beginScheduleResults(ScheduleResults *results);
+static int histogramBucket(int value);
+static double histogramValue(int bucket);
+static int runWorkers(void *(*worker)(void *), void *job, int num_items, int num_threads);
+static void *sweepWorker(void *argument);
+static int checkLibraryPrograms(const Workload *library, const ProcessTable *definitions, const char *filename);
+static void *batchWorker(void *argument);
+static int buildReplica(const Workload *base, const ReplicationConfig *config, int r, Workload *replica, int *capacity);
+static void *replicationWorker(void *argument);
+static double tCritical95(int df);
+static void summarizeMetric(const double *metrics, int stride, int count, MetricSummary *summary);
+static int compareArrival(const void *a, const void *b);
+static int compareStreamedArrival(const void *a, const void *b);
+static void orderStreamArrivals(ArrivalSource *source, int currentTime);
+static int tieredPreempts(const Process *a, const Process *b, const PolicyConfig *config);
+static void tieredQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key);
+static int tieredQuantum(const Process *process, const PolicyConfig *config);
+static void tieredSliceEnd(Process *process, int slice, const PolicyConfig *config);
+static int mlfqLevel(const Process *process, const PolicyConfig *config);
+static void mlfqQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key);
+static int mlfqQuantum(const Process *process, const PolicyConfig *config);
+static int mlfqPreempts(const Process *a, const Process *b, const PolicyConfig *config);
+static void cfsArrival(Process *process, long long floor, const PolicyConfig *config);
+static void cfsQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key);
+static int cfsQuantum(const Process *process, const PolicyConfig *config);
+static int cfsPreempts(const Process *a, const Process *b, const PolicyConfig *config);
+static void cfsSliceEnd(Process *process, int slice, const PolicyConfig *config);
+static long long edfDeadline(const Process *process, const PolicyConfig *config);
+static void edfQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key);
+static int edfQuantum(const Process *process, const PolicyConfig *config);
+static int edfPreempts(const Process *a, const Process *b, const PolicyConfig *config);
+static int checkPolicy(const PolicyConfig *config);
+static const SchedulingPolicy *schedulingPolicy(const PolicyConfig *config);
+static int reserveReadyQueue(ReadyQueue *queue, int capacity);
+static int initReadyQueue(ReadyQueue *queue, Process processes[], int num_processes, const PolicyConfig *config);
+static void freeReadyQueue(ReadyQueue *queue);
+static int heapBefore(const ProcessHeap *heap, int i, int j);
+static int bestChild(const ProcessHeap *heap, int first, int count);
+static void heapPlace(ReadyQueue *queue, ProcessHeap *heap, int i, long long key, long sequence, int index);
+static void heapSiftUp(ReadyQueue *queue, ProcessHeap *heap, int i);
+static void heapSiftDown(ReadyQueue *queue, ProcessHeap *heap, int i);
+static void removeQueuedProcess(ReadyQueue *queue, int index, int queueClass);
+static void admitProcess(ReadyQueue *queue, int index);
+static void enqueueProcess(ReadyQueue *queue, int index);
+static void requeueProcess(ReadyQueue *queue, int index);
+static int dequeueNextProcess(ReadyQueue *queue);
+static int joinPath(char *buffer, size_t size, const char *directory, const char *name);
+static int loadProgramFiles(Workload *workload, const InstructionCatalog *catalog, const char *directory, const char *wanted, int numPrograms,
+                            int num_threads);
+static uint64_t contentHash(const char *data, size_t size);
+static int loadProgram(ProgramLoadJob *job, int i);
+static void *programLoadWorker(void *argument);
+static int runProgramLoadPhase(ProgramLoadJob *job, int phase);
+static int findRepresentatives(ProgramLoadJob *job);
+static int loadPrograms(Workload *workload, const InstructionCatalog *catalog, const char *directory, int num_threads);
+static int programNumber(const char *name);
+static int loadInstructionCatalog(const char *directory, InstructionCatalog *catalog);
+static size_t traceSectionSize(uint32_t count);
+static int writeTraceSection(FILE *file, const int32_t *values, uint32_t count);
+static uint64_t nextRandom(uint64_t *state);
+static double randomUnit(uint64_t *state);
+static int randomRange(uint64_t *state, int low, int high);
+static double randomExponential(uint64_t *state, double mean);
+static int drawInstructionLength(uint64_t *state, const GeneratorConfig *config);
+static int checkGeneratorConfig(const GeneratorConfig *config);
+static int closeTextFile(FILE *file, const char *filename);
+static double monotonicMs(void);
+static int buildInstructionCatalog(const InstructionTable *instructions, InstructionCatalog *catalog);
+static int lookupInstructionBurst(const InstructionCatalog *catalog, int id);
+static int computeBurstPrefix(InstructionPool *pool, int offset, int count, const InstructionCatalog *catalog, const char *filename);
+static int prefixUpperBound(const int *prefix, int low, int high, int value);
+static int executedTime(const InstructionPool *pool, const Process *process);
+static int runnableWithin(const InstructionPool *pool, const Process *process, int budget);
+static int runUntilBoundary(const InstructionPool *pool, const Process *process, int elapsed);
 
-    //printf("Average Turnaround Time: %.2f ms\n", avgTurnaround);
-    //printf("Average Waiting Time: %.2f ms\n", avgWaiting);
+// Command line tool
+#ifndef SCHEDULER_NO_MAIN
+static void printAverages(FILE *stream, const ScheduleAverages *averages);
+static void printCoreStats(FILE *stream, const ScheduleResults *results);
+static int parseIntList(const char *text, IntList *list);
+static int parsePolicyList(const char *text, IntList *list);
+static int parseCountOption(const char *option, const char *text, int minimum, int *value);
+static int parseRatioOption(const char *option, const char *text, double *value);
+static int buildPolicyGrid(const IntList lists[SWEEP_PARAMETERS], PolicyConfig **grid);
+static void printSweepTable(FILE *stream, const PolicyConfig configs[], const ScheduleAverages results[], int num_configs);
+static void printBatchTable(FILE *stream, const char *const paths[], const BatchResult results[], int num_paths);
+static int addBatchPath(char ***paths, int *count, int *capacity, const char *directory, const char *name);
+static int listBatchFiles(const char *path, char ***paths, int *count);
+static int comparePaths(const void *a, const void *b);
+static void printReplicationSummary(FILE *stream, const ReplicationSummary *summary);
+static void printUsage(const char *program);
+static int parseGeneratorOption(int argc, char *argv[], int *i, GeneratorConfig *config);
+static int runBenchmark(FILE *stream, const GeneratorConfig *generator, const PolicyConfig *policy, const IntList *sizes);
+static int exportRecording(const char *path, int (*writer)(FILE *, const EventRecorder *), const EventRecorder *recorder);
+static int instructionLength(const InstructionPool *pool, const Process *process, int k);
+static int referenceOutranks(const Process *a, long sa, const Process *b, long sb);
+static long referenceSchedule(const Workload *workload, const PolicyConfig *config, int turnaround[], int waiting[]);
+static int runFuzz(FILE *stream, unsigned long long seed, int cases);
+static int writeGolden(FILE *stream, const EventRecorder *recorder);
+static int checkGolden(const char *path, const EventRecorder *recorder);
+#endif
 
-    // Write averages to the output file
-    char fileName[20];  // Adjust the size accordingly
-    sprintf(fileName, "output.txt");  // Create the output file name
 
-    FILE* outputFile = fopen(fileName, "w");  // Open file for writing
+// Function to compile the instruction list into a direct-indexed table
+static int buildInstructionCatalog(const InstructionTable *instructions, InstructionCatalog *catalog) {
+    catalog->max_id = 0;
+    catalog->exit_burst = 10; // exit costs 10 ms unless instructions.txt says otherwise
 
-    if (outputFile != NULL) {
-        if (fmod(avgWaiting, 1.0) == 0.0) {
-            printf("%.0f\n", avgWaiting);
+    for (int i = 0; i < instructions->count; i++) {
+        const Instruction *instruction = &instructions->items[i];
+        if (instruction->id == -1) {
+            continue;
+        }
+        if (instruction->id < 1 || instruction->id > MAX_ID || instruction->burst_time < 0) {
+            fprintf(stderr, "Invalid instruction instr%d %d\n", instruction->id, instruction->burst_time);
+            return -1;
         }
-        else {
-            printf("%.2f\n", avgWaiting);
+        if (instruction->id > catalog->max_id) {
+            catalog->max_id = instruction->id;
         }
-        if (fmod(avgTurnaround, 1.0) == 0.0) {
-            printf("%.0f\n", avgTurnaround);
+    }
+
+    catalog->burst_by_id = malloc(((size_t)catalog->max_id + 1) * sizeof(int));
+    if (catalog->burst_by_id == NULL) {
+        perror("Error allocating instruction catalog");
+        return -1;
+    }
+    for (int id = 0; id <= catalog->max_id; id++) {
+        catalog->burst_by_id[id] = -1;
+    }
+
+    for (int i = 0; i < instructions->count; i++) {
+        const Instruction *instruction = &instructions->items[i];
+        if (instruction->id == -1) {
+            catalog->exit_burst = instruction->burst_time;
+            continue;
         }
-        else {
-            printf("%.2f\n", avgTurnaround);
+        if (catalog->burst_by_id[instruction->id] != -1) {
+            fprintf(stderr, "Duplicate instruction instr%d\n", instruction->id);
+            return -1;
         }
+        catalog->burst_by_id[instruction->id] = instruction->burst_time;
+    }
+    return 0;
+}
 
-        fclose(outputFile);  // Close the file
-    } else {
-        printf("Error opening the output file.\n");
+// Function to get the burst time of an instruction id, -1 if it is not in the catalog
+static int lookupInstructionBurst(const InstructionCatalog *catalog, int id) {
+    if (id == -1) {
+        return catalog->exit_burst;
+    }
+    if (id < 1 || id > catalog->max_id) {
+        return -1;
     }
+    return catalog->burst_by_id[id];
 }
 
-// Function to perform preemptive priority scheduling
-/*
-     * notes
-     * use round robin for equal priorities
-     * do a comparison of priorities at arrival times
-     * line number of the interrupted process must be recorded
-     * each context switch takes 10 ms to do.
-     * platinums are not preempted and executed at arrival (acc to priority if they arrive at the same time)
-     *  arrive at the same time, same type, same priority: according to name. P1 beforE p2
-     * Silver: 80ms Gold & Plat: 120ms
-     * İf silver gets 3 quantums of execution, it becomes gold
-     * if gold gets 5 quantums of execution, it become platinum
-     * instructions are atomic. dont cut them in t
-     * Reminder:
-     * Turnaround time = Time of Completion - Time Of Arrival
-     * Waiting Time = Turnaround Time - Burst Time
-     */
+// Function to fill the cumulative burst times of one program, returns its total burst time
+static int computeBurstPrefix(InstructionPool *pool, int offset, int count, const InstructionCatalog *catalog, const char *filename) {
+    int total = 0;
+
+    for (int k = 0; k < count; k++) {
+        int burst = lookupInstructionBurst(catalog, pool->ids[offset + k]);
+        if (burst == -1) {
+            fprintf(stderr, "%s: unknown instruction instr%d (instruction %d)\n", filename, pool->ids[offset + k], k + 1);
+            return -1;
+        }
+        total += burst;
+        pool->burst_prefix[offset + k] = total;
+    }
+    return total;
+}
 
-void preemptivePriorityScheduling(Process allProcesses[], Process processes[], int num_processes) {
+// Function to find the first instruction in [low, high) whose cumulative burst exceeds value
+static int prefixUpperBound(const int *prefix, int low, int high, int value) {
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (prefix[mid] <= value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
 
-    //always a context switch at start
-    int currentTime = 0;
-    currentTime +=10;
+// Function to get the time already spent on completed instructions of a process
+static int executedTime(const InstructionPool *pool, const Process *process) {
+    if (process->instruction_index == 0) {
+        return 0;
+    }
+    return pool->burst_prefix[process->instruction_offset + process->instruction_index - 1];
+}
+
+// Function to get how long a process can run within budget ms without cutting an instruction
+// binary search over the prefix sums for the last instruction boundary that fits
+static int runnableWithin(const InstructionPool *pool, const Process *process, int budget) {
+    const int *prefix = &pool->burst_prefix[process->instruction_offset];
+    int executed = executedTime(pool, process);
+    int done = prefixUpperBound(prefix, process->instruction_index, process->instruction_count, executed + budget);
 
-    for(int i = 0;i<num_processes;i++){
-        //fill in missing details in the subset list.
+    if (done == process->instruction_index) {
+        return 0;
+    }
+    return prefix[done - 1] - executed;
+}
 
-        //priority,type,arrival time, and id is from definition.txt
-        //rem time, burst time from all processes (PX.txt definitions)
+// Function to get how long a process runs until the first instruction boundary at or after elapsed ms
+// at least one instruction always runs once a process is dispatched
+static int runUntilBoundary(const InstructionPool *pool, const Process *process, int elapsed) {
+    const int *prefix = &pool->burst_prefix[process->instruction_offset];
+    int executed = executedTime(pool, process);
+    int target = executed + (elapsed > 1 ? elapsed : 1);
+    int next = prefixUpperBound(prefix, process->instruction_index, process->instruction_count, target - 1);
 
-        processes[i].remaining_time = allProcesses[processes[i].id-1].remaining_time;
-        processes[i].burst_time = allProcesses[processes[i].id-1].burst_time;
-        processes[i].completed = 0;  // Not completed
-        processes[i].instruction_index = 0; //starting from first instruction
+    if (next == process->instruction_count) {
+        next = process->instruction_count - 1;
+    }
+    return prefix[next] - executed;
+}
 
+// Function to make room for at least needed items in a growable table
+static int reserveItems(void **items, int *capacity, int needed, size_t itemSize) {
+    if (needed <= *capacity) {
+        return 0;
     }
-    int silverQuantum = 80;
-    int goldQuantum = 120;
 
-    int silverToGoldThreshold = 3*80;
-    int goldToPlatinumThreshold = 5*120;
+    int newCapacity = *capacity > 0 ? *capacity : 16;
+    while (newCapacity < needed) {
+        newCapacity *= 2;
+    }
 
+    void *grown = realloc(*items, (size_t)newCapacity * itemSize);
+    if (grown == NULL) {
+        perror("Error growing table");
+        return -1;
+    }
+    *items = grown;
+    *capacity = newCapacity;
+    return 0;
+}
 
-    int turnaroundTimes[num_processes];
-    int waitingTimes[num_processes];
+// Function to map a whole input file into memory (empty files map to an empty buffer)
+static int mapFile(const char *filename, MappedFile *file) {
+    memset(file, 0, sizeof(*file));
+    file->data = "";
 
-    // Initialize arrays
-    for (int i = 0; i < num_processes; i++) {
-        turnaroundTimes[i] = 0;
-        waitingTimes[i] = 0;
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Error opening file %s: %s\n", filename, strerror(errno));
+        return -1;
     }
 
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        fprintf(stderr, "Error reading file %s: %s\n", filename, strerror(errno));
+        close(fd);
+        return -1;
+    }
 
-    // Main scheduling loop
-    //this should be while 1
-    //while(1){
-    for (int i = 0; i < 50; i++) {
-        int foundPlatProcess = 0;
-        int selectedProcess = -1;
-
-        // Check for platinum processes arriving
-        for (int i = 0; i < num_processes; i++) {
-            if (processes[i].arrival_time <= currentTime && processes[i].type == 1 && processes[i].completed  == 0) {
-                currentTime += processes[i].burst_time;
-                processes[i].remaining_time = 0;
-                processes[i].completed = 1;
-                foundPlatProcess = 1;
-                turnaroundTimes[i] = currentTime - processes[i].arrival_time;
-                waitingTimes[i] = turnaroundTimes[i] - processes[i].burst_time;
-                break;
-            }
+    if (info.st_size > 0) {
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "Error mapping file %s: %s\n", filename, strerror(errno));
+            close(fd);
+            return -1;
         }
+        posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+        file->data = data;
+        file->size = (size_t)info.st_size;
+        file->mapped = 1;
+    }
 
-        //context switch
+    close(fd);
+    return 0;
+}
 
-        if (foundPlatProcess) {
-            // Wait for context switch
-            foundPlatProcess = 0;
-            currentTime += 10;
-            continue;
-        }
+static void unmapFile(MappedFile *file) {
+    if (file->mapped) {
+        munmap((void *)file->data, file->size);
+    }
+    file->mapped = 0;
+    file->data = "";
+    file->size = 0;
+}
 
+static void initTokenizer(Tokenizer *tok, const MappedFile *file, const char *filename) {
+    tok->pos = file->data;
+    tok->end = file->data + file->size;
+    tok->line_start = file->data;
+    tok->line = 1;
+    tok->filename = filename;
+}
 
-        // Check for other processes
-        int highestPriority = -1;
-        int lowestPriority = INT_MAX; // Initialize with a large value for rr
-        selectedProcess = -1;
+// Function to report a parse error at the tokenizer position as file:line:column
+static int tokenizerError(const Tokenizer *tok, const char *message) {
+    fprintf(stderr, "%s:%d:%d: %s\n", tok->filename, tok->line, (int)(tok->pos - tok->line_start) + 1, message);
+    return -1;
+}
 
+// Function to skip spaces and tabs (and \r of CRLF files) within the current line
+static void skipBlanks(Tokenizer *tok) {
+    while (tok->pos < tok->end && (*tok->pos == ' ' || *tok->pos == '\t' || *tok->pos == '\r')) {
+        tok->pos++;
+    }
+}
 
-        for (int i = 0; i < num_processes; i++) {
-            if (processes[i].completed) {
-                //skip
-                continue;
-            }
-            //pick the one with the highest priority
-            lowestPriority = 100000;
-            highestPriority = -100000;
-            if (processes[i].arrival_time <= currentTime && processes[i].remaining_time > 0) {
-                // Update the lowest priority among active processes
-                if (processes[i].priority < lowestPriority) {
-                    lowestPriority = processes[i].priority;
-                }
-                if (processes[i].priority > highestPriority) {
-                    highestPriority = processes[i].priority;
-                    selectedProcess = i;
-                }
-            }
+// Function to skip blank lines, returns 1 when there is another non-empty line
+static int nextLine(Tokenizer *tok) {
+    for (;;) {
+        skipBlanks(tok);
+        if (tok->pos == tok->end) {
+            return 0;
         }
+        if (*tok->pos != '\n') {
+            return 1;
+        }
+        tok->pos++;
+        tok->line++;
+        tok->line_start = tok->pos;
+    }
+}
 
-        if (selectedProcess != -1 && !processes[selectedProcess].completed) {
+// Function to require the end of the current line (or of the file)
+static int endLine(Tokenizer *tok) {
+    skipBlanks(tok);
+    if (tok->pos == tok->end) {
+        return 0;
+    }
+    if (*tok->pos != '\n') {
+        return tokenizerError(tok, "unexpected text at end of line");
+    }
+    tok->pos++;
+    tok->line++;
+    tok->line_start = tok->pos;
+    return 0;
+}
 
+// Function to consume a keyword if the input continues with it
+static int matchKeyword(Tokenizer *tok, const char *keyword, size_t length) {
+    if ((size_t)(tok->end - tok->pos) < length || memcmp(tok->pos, keyword, length) != 0) {
+        return 0;
+    }
+    tok->pos += length;
+    return 1;
+}
 
-            //to avoid unnecessary CONTEXT SWITCH
-            //calculate ongoing processes
-            int ongoing = num_processes;
-            for (int i = 0; i < num_processes; i++) {
-                if (processes[i].remaining_time <= 0) {
-                    ongoing--;
-                }
-            }
-            //only 1 left in the system
-            if (ongoing == 1) {
-                for (int i = 0; i < num_processes; i++) {
-                    if (processes[i].remaining_time > 0) {
-                        //execute it and terminate
-                        currentTime += processes[i].remaining_time;
-                        if(processes[i].type == 2){
-                            //the context switches
-                            currentTime+= (ceil((processes[i].remaining_time/goldQuantum)) - 1)*10;
-                        }
-
-                        processes[i].remaining_time = 0;
-                        turnaroundTimes[i] = currentTime - processes[i].arrival_time;
-                        waitingTimes[i] = turnaroundTimes[i] - processes[i].burst_time;
-                        ongoing--;
-                        break;
-                    }
-                    if(ongoing ==0){
-                        break;
-                    }
-                }
-            }
+// Function to parse a decimal integer, an optional leading '-' included
+static int parseInt(Tokenizer *tok, int *value) {
+    int negative = 0;
+    long result = 0;
 
-            if (processes[selectedProcess].type == 3) {
-                // Silver process
-                if (processes[selectedProcess].remaining_time <= silverQuantum) {
-                    //if there are plat newcomers do the following
-                    foundPlatProcess = 0;
-                    // Check for platinum processes arriving
-                    for (int p = 0; p < num_processes; p++) {
-                        if (processes[p].arrival_time <= currentTime + processes[selectedProcess].remaining_time && processes[p].type == 1 && processes[p].completed  == 0) {
-                            int execTime = processes[p].arrival_time - processes[selectedProcess].remaining_time;
-                            currentTime += execTime;
-                            processes[p].remaining_time -= execTime;
-                            foundPlatProcess = 1;
-                            break;
-                        }
-                    }
-                    if(!foundPlatProcess) {
-                        currentTime += processes[selectedProcess].remaining_time;
-                        processes[selectedProcess].remaining_time = 0;
-                        processes[selectedProcess].completed = 1;
-                    }
+    if (tok->pos < tok->end && *tok->pos == '-') {
+        negative = 1;
+        tok->pos++;
+    }
+    if (tok->pos == tok->end || *tok->pos < '0' || *tok->pos > '9') {
+        return tokenizerError(tok, "expected a number");
+    }
+    while (tok->pos < tok->end && *tok->pos >= '0' && *tok->pos <= '9') {
+        result = result * 10 + (*tok->pos - '0');
+        if (result > 2147483647L) {
+            return tokenizerError(tok, "number out of range");
+        }
+        tok->pos++;
+    }
 
-                } else {
-                    foundPlatProcess = 0;
-                    // Check for platinum processes arriving
-                    for (int p = 0; p < num_processes; p++) {
-                        if (processes[p].arrival_time <= currentTime + silverQuantum && processes[p].type == 1 && processes[p].completed  == 0) {
-                            int execTime = processes[p].arrival_time - processes[selectedProcess].remaining_time;
-                            currentTime += execTime;
-                            processes[p].remaining_time -= execTime;
-                            foundPlatProcess = 1;
-                            break;
-                        }
-                    }
-                    if(!foundPlatProcess) {
-                        // Execute one quantum for silver
-                        currentTime += silverQuantum;
-                        processes[selectedProcess].remaining_time -= silverQuantum;
-                    }
-                }
+    *value = negative ? (int)-result : (int)result;
+    return 0;
+}
 
-                processes[selectedProcess].priority = lowestPriority - 1;
-
-            } else if (processes[selectedProcess].type == 2) {
-                // Gold process
-                if (processes[selectedProcess].remaining_time <= goldQuantum) {
-                    //if there are plat newcomers do the following
-                    foundPlatProcess = 0;
-                    // Check for platinum processes arriving
-                    for (int p = 0; p < num_processes; p++) {
-                        if (processes[p].arrival_time <= currentTime + processes[selectedProcess].remaining_time && processes[p].type == 1 && processes[p].completed  == 0) {
-                            int execTime = processes[p].arrival_time - processes[selectedProcess].remaining_time;
-                            currentTime += execTime;
-                            processes[p].remaining_time -= execTime;
-                            foundPlatProcess = 1;
-                            break;
-                        }
-                    }
-                    if(!foundPlatProcess) {
-                        currentTime += processes[selectedProcess].remaining_time;
-                        processes[selectedProcess].remaining_time = 0;
-                        processes[selectedProcess].completed = 1;
-                    }
+// Function to parse a number that must be followed by at least one blank
+static int parseField(Tokenizer *tok, int *value) {
+    if (parseInt(tok, value) == -1) {
+        return -1;
+    }
+    if (tok->pos == tok->end || (*tok->pos != ' ' && *tok->pos != '\t')) {
+        return tokenizerError(tok, "expected a blank after the number");
+    }
+    skipBlanks(tok);
+    return 0;
+}
 
-                } else {
-                    foundPlatProcess = 0;
-                    // Check for platinum processes arriving
-                    for (int p = 0; p < num_processes; p++) {
-                        if (processes[p].arrival_time <= currentTime + goldQuantum && processes[p].type == 1 &&
-                            processes[p].completed == 0) {
-                            int execTime = processes[selectedProcess].remaining_time - processes[p].arrival_time;
-                            currentTime += execTime;
-                            processes[p].remaining_time -= execTime;
-                            foundPlatProcess = 1;
-                            break;
-                        }
-                    }
-                    if (!foundPlatProcess) {
-                        // Execute one quantum for silver
-                        currentTime += goldQuantum;
-                        processes[selectedProcess].remaining_time -= goldQuantum;
-                    }
-                }
-                processes[selectedProcess].priority = lowestPriority - 1;
-            }
+// Function to parse PLATINUM/GOLD/SILVER into the type enumeration
+static int parseType(Tokenizer *tok, int *type) {
+    if (matchKeyword(tok, "PLATINUM", 8)) {
+        *type = 1;
+    } else if (matchKeyword(tok, "GOLD", 4)) {
+        *type = 2;
+    } else if (matchKeyword(tok, "SILVER", 6)) {
+        *type = 3;
+    } else {
+        return tokenizerError(tok, "expected PLATINUM, GOLD or SILVER");
+    }
+    return 0;
+}
 
-            //updateif the process arrived
-            if(processes[selectedProcess].arrival_time <= currentTime) {
-                turnaroundTimes[selectedProcess] = currentTime - processes[selectedProcess].arrival_time;
-                waitingTimes[selectedProcess] = turnaroundTimes[selectedProcess] - processes[selectedProcess].burst_time;
-            }
+// Function to read instructions from file and create Instruction structures
+// Format: one "instrN BURST" per line, then "exit BURST"
+static int readInstructionsFromFile(const char *filename, InstructionTable *instructions) {
+    MappedFile file;
+    if (mapFile(filename, &file) == -1) {
+        return -1; // Return -1 on failure
+    }
 
-            //set the priority to the one less of the least priorty for rr
-            processes[selectedProcess].priority = lowestPriority - 1;
-            lowestPriority = 1000000;
+    Tokenizer tok;
+    initTokenizer(&tok, &file, filename);
 
+    int result = 0;
+    while (result == 0 && nextLine(&tok)) {
+        Instruction instruction;
+
+        if (matchKeyword(&tok, "instr", 5)) {
+            result = parseInt(&tok, &instruction.id);
+        } else if (matchKeyword(&tok, "exit", 4)) {
+            instruction.id = -1; // Use a special id (e.g., -1) to represent "exit"
         } else {
-            // No process is ready keep waiting
-            currentTime++;
+            result = tokenizerError(&tok, "expected instrN or exit");
+        }
+        if (result == 0) {
+            skipBlanks(&tok);
+            result = parseInt(&tok, &instruction.burst_time);
         }
+        if (result == 0) {
+            result = endLine(&tok);
+        }
+        if (result == 0) {
+            result = reserveItems((void **)&instructions->items, &instructions->capacity, instructions->count + 1, sizeof(Instruction));
+        }
+        if (result == 0) {
+            instructions->items[instructions->count++] = instruction;
+        }
+    }
 
+    unmapFile(&file);
+    return result == -1 ? -1 : instructions->count; // Return the number of instructions read
+}
 
-        //check thresholds for aging
-        for (int i = 0; i < num_processes; i++) {
-            //burst time - remaining = execution time
-            if (processes[i].burst_time - processes[i].remaining_time >= silverToGoldThreshold) {
-                if(processes[i].type == 3){
-                    //promote silver to gold
-                    processes[i].type = 2;
-                }
-            }
+// Function to read the instructions of one program from its mapped file, appending their ids to the pool
+// Format: one "instrN" per line, then "exit"; anything after exit is ignored
+static int readInstructionsForProcessesFromFile(const MappedFile *file, const char *filename, InstructionPool *pool) {
+    Tokenizer tok;
+    initTokenizer(&tok, file, filename);
 
-            if (processes[i].burst_time - processes[i].remaining_time >= goldToPlatinumThreshold) {
-                if(processes[i].type == 2){
-                    //promote gold to platinum
-                    processes[i].type = 1;
-                }
-            }
+    int count = 0;
+    int result = 0;
+    while (result == 0 && nextLine(&tok)) {
+        int id;
 
+        if (matchKeyword(&tok, "exit", 4)) {
+            result = endLine(&tok);
+            break;
         }
-
-        //calculate ongoing processes
-        int ongoing = num_processes;
-        for (int i = 0; i < num_processes; i++) {
-            if (processes[i].remaining_time <= 0) {
-                ongoing--;
-            }
+        if (!matchKeyword(&tok, "instr", 5)) {
+            result = tokenizerError(&tok, "expected instrN or exit");
+            break;
         }
-
-        //only 1 left in the system
-        if (ongoing == 1) {
-            for (int i = 0; i < num_processes; i++) {
-                if (processes[i].remaining_time > 0) {
-                    //execute it and terminate
-                    currentTime += processes[i].remaining_time;
-                    processes[i].remaining_time = 0;
-                    ongoing--;
-                    break;
-                }
-            }
+        result = parseInt(&tok, &id);
+        if (result == 0) {
+            result = endLine(&tok);
         }
-
-
-        // Check if all processes are completed
-        int allCompleted = 1;
-        for (int i = 0; i < num_processes; i++) {
-            if (processes[i].remaining_time > 0) {
-                allCompleted = 0;
-                break;
-            }
+        if (result == 0) {
+            result = reserveItems((void **)&pool->ids, &pool->capacity, pool->count + 1, sizeof(int));
         }
-
-        if (allCompleted) {
-            break;
+        if (result == 0) {
+            pool->ids[pool->count++] = id;
+            count++;
         }
     }
 
-    // Print average turnaround time and average waiting time
-    calculateAverages(turnaroundTimes, waitingTimes, num_processes);
+    // Every program ends with exit, whether or not the file spells it out
+    if (result == 0) {
+        result = reserveItems((void **)&pool->ids, &pool->capacity, pool->count + 1, sizeof(int));
+    }
+    if (result == 0) {
+        pool->ids[pool->count++] = -1;
+        count++;
+    }
+    return result == -1 ? -1 : count;
 }
 
-int main() {
-    Instruction instructionLengths[20];
-
-    // Always fixed - Read instructions from file
-    // Instruction structure: id - burst time
-    int numInstructions = readInstructionsFromFile("instructions.txt", instructionLengths);
+// Function to parse one definition line into a Process, the tokenizer at the start of the line
+// Assuming that the line format is: ID PRIORITY ARRIVAL_TIME TYPE
+static int parseDefinitionLine(Tokenizer *tok, Process *process) {
+    memset(process, 0, sizeof(*process));
 
-    if (numInstructions == -1) {
-        return 1;
+    if (!matchKeyword(tok, "P", 1)) {
+        return tokenizerError(tok, "expected a process name like P1");
     }
+    if (parseField(tok, &process->id) == -1 || parseField(tok, &process->priority) == -1 ||
+        parseField(tok, &process->arrival_time) == -1 || parseType(tok, &process->type) == -1 || endLine(tok) == -1) {
+        return -1;
+    }
+    return 0;
+}
 
-    // Create 10 processes
-    Process processes[10];
-
-    // Always fixed, read 10 process contents / instructions
-    for (int i = 0; i < 10; i++) {
-        int *instructionIds = malloc(MAX_INSTRUCTIONS * sizeof(int));
-        processes[i].id = i;
-
-        // Formulate the filename based on the index i+1 (1-based index)
-        char filename[10];
-        snprintf(filename, sizeof(filename), "P%d.txt", i + 1);
+// Function to read incoming processes from file and create Process structures
+static int readProcessesFromFile(const char *filename, ProcessTable *table) {
+    MappedFile file;
+    if (mapFile(filename, &file) == -1) {
+        return -1; // Return -1 on failure
+    }
 
-        // Read instructions
+    Tokenizer tok;
+    initTokenizer(&tok, &file, filename);
 
-        int numProcessInstructions = readInstructionsForProcessesFromFile(filename, instructionIds);
-        if (numProcessInstructions == -1) {
-              return 1;
+    int result = 0;
+    while (result == 0 && nextLine(&tok)) {
+        Process process;
+        if (parseDefinitionLine(&tok, &process) == -1) {
+            result = -1;
+            break;
         }
 
-        // Record instructions
-        // Copy instructions individually
-        for (int j = 0; j < numProcessInstructions; j++) {
-            processes[i].instructions[j] = instructionIds[j];
-            //printf("instructions set");
+        result = reserveItems((void **)&table->items, &table->capacity, table->count + 1, sizeof(Process));
+        if (result == 0) {
+            table->items[table->count++] = process;
         }
+    }
 
-  //take the total of the instruction bursts to determine process burst time.
-        //int processInstructionCount = sizeof(instructionIds);
-        int processBurstTime = 0;
-
-        //burst time calculation
-        for(int k = 0; k<numProcessInstructions; k++){
-            if(instructionIds[k] >= 1 && instructionIds[k] <= 20) {
-                Instruction *currentInstruction = getInstructionById(instructionIds[k], instructionLengths, numInstructions);
-                processBurstTime += currentInstruction->burst_time;
-            }
-        }
+    unmapFile(&file);
+    return result == -1 ? -1 : table->count; // Return the number of processes read
+}
 
-        //add 10 more for the exit instruction
-        processBurstTime += 10;
+// Function to create an empty event recorder
+EventRecorder *createEventRecorder(void) {
+    return calloc(1, sizeof(EventRecorder));
+}
 
-        processes[i].burst_time = processBurstTime;
-        processes[i].remaining_time = processBurstTime;
+void destroyEventRecorder(EventRecorder *recorder) {
+    if (recorder == NULL) {
+        return;
+    }
+    EventChunk *chunk = recorder->first;
+    while (chunk != NULL) {
+        EventChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(recorder->metrics);
+    free(recorder);
+}
 
-        free(instructionIds);
+void setEventRecorder(SchedulerContext *context, EventRecorder *recorder) {
+    context->recorder = recorder;
+}
 
+// Function to start a new log, keeping the chunks of earlier runs for reuse
+static void resetEventRecorder(EventRecorder *recorder) {
+    recorder->current = recorder->first;
+    if (recorder->current != NULL) {
+        recorder->current->count = 0;
     }
+    recorder->num_events = 0;
+    recorder->max_cpu = 0;
+    recorder->num_metrics = 0;
+    recorder->failed = 0;
+}
 
-        Process processesToSchedule[10];
-        int num_processes = readProcessesFromFile("definition.txt", processesToSchedule);
-
+// Function to append one event; a full chunk moves on to the next one, allocating it only the first time
+static void recordEvent(EventRecorder *recorder, int kind, int time, int duration, const Process *process, int cpu) {
+    EventChunk *chunk = recorder->current;
 
-        // Perform preemptive priority scheduling
-        preemptivePriorityScheduling(processes, processesToSchedule, num_processes);
+    if (chunk == NULL || chunk->count == EVENT_CHUNK_SIZE) {
+        EventChunk *next = chunk != NULL ? chunk->next : recorder->first;
+        if (next == NULL) {
+            next = malloc(sizeof(EventChunk));
+            if (next == NULL) {
+                recorder->failed = 1;
+                return;
+            }
+            next->next = NULL;
+            if (chunk != NULL) {
+                chunk->next = next;
+            } else {
+                recorder->first = next;
+            }
+        }
+        next->count = 0;
+        recorder->current = next;
+        chunk = next;
+    }
 
-    exit(1);
+    ScheduleEvent *event = &chunk->events[chunk->count++];
+    event->kind = kind;
+    event->time = time;
+    event->duration = duration;
+    event->input_index = process->input_index;
+    event->id = process->id;
+    event->type = process->type;
+    event->cpu = cpu;
+    if (cpu > recorder->max_cpu) {
+        recorder->max_cpu = cpu;
+    }
+    recorder->num_events++;
+}
+
+// Function to append the metrics of a completed process
+static void recordProcessMetrics(EventRecorder *recorder, const Process *process, int completion) {
+    if (reserveItems((void **)&recorder->metrics, &recorder->metrics_capacity, recorder->num_metrics + 1, sizeof(ProcessMetrics)) == -1) {
+        recorder->failed = 1;
+        return;
+    }
+
+    ProcessMetrics *metrics = &recorder->metrics[recorder->num_metrics++];
+    metrics->input_index = process->input_index;
+    metrics->id = process->id;
+    metrics->priority = process->priority;
+    metrics->final_type = process->type;
+    metrics->arrival_time = process->arrival_time;
+    metrics->burst_time = process->burst_time;
+    metrics->completion_time = completion;
+    metrics->response_time = process->first_run - process->arrival_time;
+    metrics->context_switches = process->context_switches;
+    metrics->preemptions = process->preemptions;
+}
+
+// Function to get the name of a type for the exports
+static const char *typeName(int type) {
+    static const char *const names[] = {"PLATINUM", "GOLD", "SILVER"};
+    return type >= 1 && type <= 3 ? names[type - 1] : "UNKNOWN";
+}
+
+// Function to write the event log as CSV, one event per line in recording order
+int writeEventsCsv(FILE *stream, const EventRecorder *recorder) {
+    static const char *const kinds[] = {
+        "arrival", "context_switch", "dispatch", "quantum_expired", "preempt", "promote", "complete"
+    };
+
+    fprintf(stream, "time,duration,event,process,id,type,cpu\n");
+    for (const EventChunk *chunk = recorder->first; chunk != NULL; chunk = chunk->next) {
+        for (int i = 0; i < chunk->count; i++) {
+            const ScheduleEvent *event = &chunk->events[i];
+            fprintf(stream, "%d,%d,%s,%d,P%d,%s,", event->time, event->duration, kinds[event->kind],
+                    event->input_index, event->id, typeName(event->type));
+            if (event->cpu != -1) {
+                fprintf(stream, "%d", event->cpu);
+            }
+            fputc('\n', stream);
+        }
+        if (chunk == recorder->current) {
+            break;
+        }
+    }
+    return ferror(stream) ? -1 : 0;
+}
+
+// Function to write the per-process metrics as CSV, in completion order
+int writeProcessMetricsCsv(FILE *stream, const EventRecorder *recorder) {
+    fprintf(stream, "process,id,priority,final_type,arrival,burst,completion,turnaround,waiting,response,context_switches,preemptions\n");
+    for (int i = 0; i < recorder->num_metrics; i++) {
+        const ProcessMetrics *metrics = &recorder->metrics[i];
+        int turnaround = metrics->completion_time - metrics->arrival_time;
+        fprintf(stream, "%d,P%d,%d,%s,%d,%d,%d,%d,%d,%d,%d,%d\n", metrics->input_index, metrics->id, metrics->priority,
+                typeName(metrics->final_type), metrics->arrival_time, metrics->burst_time, metrics->completion_time,
+                turnaround, turnaround - metrics->burst_time, metrics->response_time,
+                metrics->context_switches, metrics->preemptions);
+    }
+    return ferror(stream) ? -1 : 0;
+}
+
+// Function to write the event log in the Chrome trace-event format (chrome://tracing, Perfetto)
+// CPU slices and context switches form a Gantt chart with one track per CPU, the other events are instants
+// Simulated ms are written as trace us so the viewer's ms read as simulated ms
+int writeChromeTrace(FILE *stream, const EventRecorder *recorder) {
+    static const char *const kinds[] = {
+        "arrival", "context switch", "run", "quantum expired", "preempt", "promote", "complete"
+    };
+
+    fprintf(stream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(stream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"events\"}}");
+    for (int c = 0; c <= recorder->max_cpu; c++) {
+        fprintf(stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU %d\"}}", c + 1, c);
+    }
+    for (const EventChunk *chunk = recorder->first; chunk != NULL; chunk = chunk->next) {
+        for (int i = 0; i < chunk->count; i++) {
+            const ScheduleEvent *event = &chunk->events[i];
+
+            if (event->kind == EVENT_DISPATCH || event->kind == EVENT_CONTEXT_SWITCH) {
+                fprintf(stream, ",\n{\"name\":\"%sP%d\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%d,\"dur\":%d,",
+                        event->kind == EVENT_DISPATCH ? "" : "switch to ", event->id, kinds[event->kind],
+                        event->cpu + 1, event->time, event->duration);
+            } else {
+                fprintf(stream, ",\n{\"name\":\"%s P%d\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":0,\"ts\":%d,",
+                        kinds[event->kind], event->id, kinds[event->kind], event->time);
+            }
+            fprintf(stream, "\"args\":{\"process\":%d,\"type\":\"%s\"}}", event->input_index, typeName(event->type));
+        }
+        if (chunk == recorder->current) {
+            break;
+        }
+    }
+    fprintf(stream, "\n]}\n");
+    return ferror(stream) ? -1 : 0;
+}
+
+// Function to calculate average turnaround time and average waiting time from the run totals
+static void calculateAverages(ScheduleResults *results) {
+    long completed = results->num_completed;
+
+    results->averages.avg_turnaround = completed > 0 ? (double)results->total_turnaround / completed : 0.0;
+    results->averages.avg_waiting = completed > 0 ? (double)results->total_waiting / completed : 0.0;
+    results->averages.avg_response = completed > 0 ? (double)results->total_response / completed : 0.0;
+    results->averages.throughput = results->makespan > 0 ? completed * 1000.0 / results->makespan : 0.0;
+    results->averages.deadline_miss_rate = completed > 0 ? (double)results->deadline_misses / completed : 0.0;
+}
+
+// Function to make room for num_processes results when per-process results are kept
+static int reserveScheduleResults(ScheduleResults *results, int num_processes) {
+    if (results->per_process && num_processes > results->capacity) {
+        int *turnaround = realloc(results->turnaround_times, num_processes * sizeof(int));
+        if (turnaround == NULL) {
+            return -1;
+        }
+        results->turnaround_times = turnaround;
+
+        int *waiting = realloc(results->waiting_times, num_processes * sizeof(int));
+        if (waiting == NULL) {
+            return -1;
+        }
+        results->waiting_times = waiting;
+        results->capacity = num_processes;
+    }
+    results->num_processes = num_processes;
+    return 0;
+}
+
+void freeScheduleResults(ScheduleResults *results) {
+    free(results->turnaround_times);
+    free(results->waiting_times);
+    free(results->cores);
+    free(results->type_stats);
+    memset(results, 0, sizeof(*results));
+}
+
+// Function to map a value to its histogram bucket: exact below 128, then 64 buckets per power of two
+static int histogramBucket(int value) {
+    if (value < 128) {
+        return value > 0 ? value : 0;
+    }
+    int shift = (31 - __builtin_clz((unsigned)value)) - 6;
+    return (shift + 1) * 64 + (value >> shift) - 64;
+}
+
+// Function to get a representative value of a bucket, the middle of the values it holds
+static double histogramValue(int bucket) {
+    if (bucket < 128) {
+        return bucket;
+    }
+    int shift = bucket / 64 - 1;
+    double low = (double)((bucket % 64 + 64) << shift);
+    return low + ((1 << shift) - 1) / 2.0;
+}
+
+void resetMetricStats(MetricStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+// Function to add one sample: running count, sum, min, max, Welford mean and variance, histogram
+void addMetricSample(MetricStats *stats, int value) {
+    if (stats->count == 0 || value < stats->min) {
+        stats->min = value;
+    }
+    if (stats->count == 0 || value > stats->max) {
+        stats->max = value;
+    }
+    stats->count++;
+    stats->sum += value;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    stats->buckets[histogramBucket(value)]++;
+}
+
+// Function to merge the samples of from into into, as if into had seen them too
+// the variance terms combine with Chan's formula, histograms add bucket by bucket
+void mergeMetricStats(MetricStats *into, const MetricStats *from) {
+    if (from->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+
+    long count = into->count + from->count;
+    double delta = from->mean - into->mean;
+    into->m2 += from->m2 + delta * delta * ((double)into->count * from->count / count);
+    into->mean += delta * from->count / count;
+    into->count = count;
+    into->sum += from->sum;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        into->buckets[b] += from->buckets[b];
+    }
+}
+
+// Function to get the sample standard deviation
+double metricStddev(const MetricStats *stats) {
+    return stats->count > 1 ? sqrt(stats->m2 / (stats->count - 1)) : 0.0;
+}
+
+// Function to estimate the nearest-rank percentile p (0..1); exact below 128, within 0.8% above
+double metricPercentile(const MetricStats *stats, double p) {
+    if (stats->count == 0) {
+        return 0.0;
+    }
+
+    long rank = (long)ceil(p * stats->count);
+    if (rank < 1) {
+        rank = 1;
+    }
+    long seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen >= rank) {
+            // the extremes are known exactly, so their buckets report them
+            if (b == histogramBucket(stats->min)) {
+                return stats->min;
+            }
+            if (b == histogramBucket(stats->max)) {
+                return stats->max;
+            }
+            return histogramValue(b);
+        }
+    }
+    return stats->max;
+}
+
+// Function to merge the statistics of the processes matching an original and a final type (0 for any)
+void collectScheduleStats(const ScheduleResults *results, int originalType, int finalType, ScheduleStats *stats) {
+    resetMetricStats(&stats->waiting);
+    resetMetricStats(&stats->turnaround);
+    resetMetricStats(&stats->response);
+    if (results->type_stats == NULL) {
+        return;
+    }
+
+    for (int o = 1; o <= 3; o++) {
+        for (int f = 1; f <= 3; f++) {
+            if ((originalType != 0 && o != originalType) || (finalType != 0 && f != finalType)) {
+                continue;
+            }
+            const ScheduleStats *group = &results->type_stats[(o - 1) * 3 + f - 1];
+            mergeMetricStats(&stats->waiting, &group->waiting);
+            mergeMetricStats(&stats->turnaround, &group->turnaround);
+            mergeMetricStats(&stats->response, &group->response);
+        }
+    }
+}
+
+// Function to clear the totals and statistics of results before a run
+static int beginScheduleResults(ScheduleResults *results) {
+    if (results->type_stats == NULL) {
+        results->type_stats = malloc(9 * sizeof(ScheduleStats));
+        if (results->type_stats == NULL) {
+            perror("Error allocating statistics");
+            return -1;
+        }
+    }
+    for (int g = 0; g < 9; g++) {
+        resetMetricStats(&results->type_stats[g].waiting);
+        resetMetricStats(&results->type_stats[g].turnaround);
+        resetMetricStats(&results->type_stats[g].response);
+    }
+
+    results->num_completed = 0;
+    results->total_turnaround = 0;
+    results->total_waiting = 0;
+    results->total_response = 0;
+    results->total_context_switches = 0;
+    results->num_dispatches = 0;
+    results->peak_live = 0;
+    results->makespan = 0;
+    results->deadline_misses = 0;
+    memset(&results->profile, 0, sizeof(results->profile));
+    return 0;
+}
+
+// Function to print count, mean, spread and percentiles of every metric, overall and per type
+void printScheduleStats(FILE *stream, const ScheduleResults *results) {
+    static const char *const metricNames[3] = {"waiting", "turnaround", "response"};
+
+    fprintf(stream, "metric\tgroup\tcount\tmean\tstddev\tmin\tmax\tp50\tp95\tp99\n");
+    for (int m = 0; m < 3; m++) {
+        // all processes, then by original type, then by final type
+        for (int g = 0; g < 7; g++) {
+            ScheduleStats stats;
+            char group[32];
+            int type = g == 0 ? 0 : (g - 1) % 3 + 1;
+
+            collectScheduleStats(results, g >= 1 && g <= 3 ? type : 0, g >= 4 ? type : 0, &stats);
+            const MetricStats *metric = m == 0 ? &stats.waiting : m == 1 ? &stats.turnaround : &stats.response;
+            if (g == 0) {
+                snprintf(group, sizeof(group), "all");
+            } else {
+                snprintf(group, sizeof(group), "%s_%s", g <= 3 ? "original" : "final", typeName(type));
+            }
+            fprintf(stream, "%s\t%s\t%ld\t%.2f\t%.2f\t%d\t%d\t%.0f\t%.0f\t%.0f\n", metricNames[m], group, metric->count,
+                    metric->mean, metricStddev(metric), metric->min, metric->max, metricPercentile(metric, 0.50),
+                    metricPercentile(metric, 0.95), metricPercentile(metric, 0.99));
+        }
+    }
+}
+
+// Function to print where a run spent its wall-clock time and the hot-path counters of its scheduling loop
+void printProfile(FILE *stream, const Workload *workload, double scheduleMs, double reportMs, const ScheduleResults *results) {
+    static const char *const phaseNames[LOAD_PHASES] = {"instructions", "programs", "definitions", "trace"};
+    const ProfileCounters *profile = &results->profile;
+
+    fprintf(stream, "phase\tms\n");
+    for (int p = 0; p < LOAD_PHASES; p++) {
+        fprintf(stream, "%s\t%.3f\n", phaseNames[p], workload->load_ms[p]);
+    }
+    fprintf(stream, "schedule\t%.3f\n", scheduleMs);
+    fprintf(stream, "report\t%.3f\n", reportMs);
+
+    fprintf(stream, "counter\tvalue\n");
+    fprintf(stream, "loop_iterations\t%ld\n", profile->loop_iterations);
+    fprintf(stream, "dispatch_decisions\t%ld\n", profile->dispatch_decisions);
+    fprintf(stream, "queue_pushes\t%ld\n", profile->queue_pushes);
+    fprintf(stream, "queue_pops\t%ld\n", profile->queue_pops);
+    fprintf(stream, "context_switches\t%ld\n", profile->context_switches);
+    fprintf(stream, "switch_time_ms\t%lld\n", profile->switch_time);
+    fprintf(stream, "switch_delay_ms\t%lld\n", profile->switch_delay);
+    // share of the total turnaround spent waiting out context switches
+    fprintf(stream, "switch_delay_share\t%.4f\n",
+            results->total_turnaround > 0 ? (double)profile->switch_delay / results->total_turnaround : 0.0);
+    fprintf(stream, "preemptions\t%ld\n", profile->preemptions);
+    fprintf(stream, "platinum_preemptions\t%ld\n", profile->platinum_preemptions);
+    fprintf(stream, "promotions\t%ld\n", profile->promotions);
+    fprintf(stream, "idle_jumps\t%ld\n", profile->idle_jumps);
+    fprintf(stream, "idle_skipped_ms\t%lld\n", profile->idle_skipped);
+}
+
+SchedulerContext *createSchedulerContext(void) {
+    return calloc(1, sizeof(SchedulerContext));
+}
+
+void destroySchedulerContext(SchedulerContext *context) {
+    if (context == NULL) {
+        return;
+    }
+    finishCheckpoints(context);
+    free(context->checkpoint.data);
+    free(context->processes);
+    free(context->arrivals);
+    free(context->free_slots);
+    freeReadyQueue(&context->readyQueue);
+    for (int c = 0; c < context->num_cpu_queues; c++) {
+        freeReadyQueue(&context->cpu_queues[c]);
+    }
+    free(context->cpu_queues);
+    free(context->cpus);
+    free(context);
+}
+
+// Function to schedule a workload without modifying it; the run works on the context's copy
+int scheduleWorkload(SchedulerContext *context, const Workload *workload, const PolicyConfig *config, ScheduleResults *results) {
+    int n = workload->definitions.count;
+
+    if (checkPolicy(config) == -1) {
+        return -1;
+    }
+    if (n > context->capacity && growContextSlots(context, n) == -1) {
+        perror("Error allocating scheduler state");
+        return -1;
+    }
+    if (n > context->arrivals_capacity) {
+        Process **arrivals = realloc(context->arrivals, n * sizeof(Process *));
+        if (arrivals == NULL) {
+            perror("Error allocating scheduler state");
+            return -1;
+        }
+        context->arrivals = arrivals;
+        context->arrivals_capacity = n;
+    }
+
+    if (reserveScheduleResults(results, n) == -1 || initReadyQueue(&context->readyQueue, context->processes, n, config) == -1) {
+        perror("Error allocating scheduler state");
+        return -1;
+    }
+
+    if (n > 0) {
+        memcpy(context->processes, workload->definitions.items, n * sizeof(Process));
+    }
+
+    // Arrival order, consumed with a cursor so idle gaps are skipped in one jump
+    for (int i = 0; i < n; i++) {
+        context->arrivals[i] = &context->processes[i];
+    }
+    qsort(context->arrivals, n, sizeof(Process *), compareArrival);
+
+    ArrivalSource source;
+    memset(&source, 0, sizeof(source));
+    source.sorted = context->arrivals;
+    source.count = n;
+    return runEngine(context, &source, workload, config, results);
+}
+
+// Function to schedule definitions streamed from input; memory grows with the live processes only
+int scheduleStream(SchedulerContext *context, const Workload *library, FILE *input, const char *name,
+                   const PolicyConfig *config, ScheduleResults *results) {
+    ArrivalSource source;
+
+    if (checkPolicy(config) == -1) {
+        return -1;
+    }
+    memset(&source, 0, sizeof(source));
+    source.input = input;
+    source.name = name;
+    source.library = library;
+    source.last_arrival = INT_MIN;
+
+    context->num_slots = 0;
+    context->num_free = 0;
+    if (initReadyQueue(&context->readyQueue, context->processes, 0, config) == -1) {
+        perror("Error allocating scheduler state");
+        return -1;
+    }
+    results->num_processes = 0;
+
+    int status = runEngine(context, &source, library, config, results);
+
+    free(source.pending);
+    free(source.line_buffer);
+    return status;
+}
+
+// Function to perform preemptive priority scheduling
+/*
+     * notes
+     * use round robin for equal priorities
+     * do a comparison of priorities at arrival times
+     * line number of the interrupted process must be recorded
+     * each context switch takes 10 ms to do.
+     * platinums are not preempted and executed at arrival (acc to priority if they arrive at the same time)
+     *  arrive at the same time, same type, same priority: according to name. P1 beforE p2
+     * Silver: 80ms Gold & Plat: 120ms
+     * İf silver gets 3 quantums of execution, it becomes gold
+     * if gold gets 5 quantums of execution, it become platinum
+     * instructions are atomic. dont cut them in t
+     * Reminder:
+     * Turnaround time = Time of Completion - Time Of Arrival
+     * Waiting Time = Turnaround Time - Burst Time
+     */
+
+// Function to order processes by arrival: earlier arrival first, then P1 before P2
+static int compareArrival(const void *a, const void *b) {
+    const Process *pa = *(const Process *const *)a;
+    const Process *pb = *(const Process *const *)b;
+
+    if (pa->arrival_time != pb->arrival_time) {
+        return pa->arrival_time < pb->arrival_time ? -1 : 1;
+    }
+    if (pa->id != pb->id) {
+        return pa->id - pb->id;
+    }
+    // duplicate definitions keep their file order, as they would when streamed
+    return (pa > pb) - (pa < pb);
+}
+
+// Function to order streamed definitions by arrival, then id, then input order
+static int compareStreamedArrival(const void *a, const void *b) {
+    const Process *pa = a;
+    const Process *pb = b;
+
+    if (pa->arrival_time != pb->arrival_time) {
+        return pa->arrival_time < pb->arrival_time ? -1 : 1;
+    }
+    if (pa->id != pb->id) {
+        return pa->id - pb->id;
+    }
+    return pa->input_index - pb->input_index;
+}
+
+// Function to check whether an arriving process a preempts the running process b under POLICY_TIERED
+// platinum preempts gold and silver, otherwise only a strictly higher priority preempts
+static int tieredPreempts(const Process *a, const Process *b, const PolicyConfig *config) {
+    (void)config;
+    if ((a->type == 1) != (b->type == 1)) {
+        return a->type == 1;
+    }
+    return a->type != 1 && a->priority > b->priority;
+}
+
+// POLICY_TIERED queues by type; within gold and silver, higher priority first
+static void tieredQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key) {
+    (void)config;
+    *queueClass = process->type - 1;
+    *key = -(long long)process->priority;
+}
+
+static int tieredQuantum(const Process *process, const PolicyConfig *config) {
+    if (process->type == 1) {
+        return INT_MAX;
+    }
+    return process->type == 3 ? config->silver_quantum : config->gold_quantum;
+}
+
+// Function to age the process that just ran; only it can cross a threshold
+static void tieredSliceEnd(Process *process, int slice, const PolicyConfig *config) {
+    (void)slice;
+    //burst time - remaining = execution time
+    int executed = process->burst_time - process->remaining_time;
+    if (process->type == 3 && executed >= config->silver_to_gold_threshold) {
+        //promote silver to gold
+        process->type = 2;
+    }
+    if (process->type == 2 && executed >= config->gold_to_platinum_threshold) {
+        //promote gold to platinum
+        process->type = 1;
+    }
+}
+
+// Function to get the MLFQ level of a process from the execution time it has used so far
+// level 0 allows silver_quantum ms, level 1 twice that more, level 2 is the bottom
+static int mlfqLevel(const Process *process, const PolicyConfig *config) {
+    long long executed = process->burst_time - process->remaining_time;
+    if (executed < config->silver_quantum) {
+        return 0;
+    }
+    return executed < 3LL * config->silver_quantum ? 1 : 2;
+}
+
+// POLICY_MLFQ queues by level, first in first out within a level
+static void mlfqQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key) {
+    *queueClass = mlfqLevel(process, config);
+    *key = 0;
+}
+
+// Function to get what is left of the level's allotment, so preempted processes do not start over
+static int mlfqQuantum(const Process *process, const PolicyConfig *config) {
+    int executed = process->burst_time - process->remaining_time;
+    switch (mlfqLevel(process, config)) {
+    case 0:
+        return config->silver_quantum - executed;
+    case 1:
+        return 3 * config->silver_quantum - executed;
+    default:
+        return 4 * config->silver_quantum;
+    }
+}
+
+// arrivals start at level 0 and preempt anything below it
+static int mlfqPreempts(const Process *a, const Process *b, const PolicyConfig *config) {
+    (void)a;
+    return mlfqLevel(b, config) > 0;
+}
+
+// Function to start an arrival at the virtual runtime of the queue, so it neither starves others nor waits for them
+static void cfsArrival(Process *process, long long floor, const PolicyConfig *config) {
+    (void)config;
+    process->vruntime = floor;
+}
+
+static void cfsQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key) {
+    (void)config;
+    *queueClass = 0;
+    *key = process->vruntime;
+}
+
+static int cfsQuantum(const Process *process, const PolicyConfig *config) {
+    (void)process;
+    return config->gold_quantum;
+}
+
+// arrivals wait for the end of the current slice
+static int cfsPreempts(const Process *a, const Process *b, const PolicyConfig *config) {
+    (void)a;
+    (void)b;
+    (void)config;
+    return 0;
+}
+
+// Function to charge a slice: a process of priority p gains virtual runtime 1/p as fast as one of priority 1
+static void cfsSliceEnd(Process *process, int slice, const PolicyConfig *config) {
+    (void)config;
+    process->vruntime += (long long)slice * CFS_WEIGHT_SCALE / (process->priority > 0 ? process->priority : 1);
+}
+
+static long long edfDeadline(const Process *process, const PolicyConfig *config) {
+    return (long long)process->arrival_time + config->deadlines[process->type - 1];
+}
+
+static void edfQueueKey(const Process *process, const PolicyConfig *config, int *queueClass, long long *key) {
+    *queueClass = 0;
+    *key = edfDeadline(process, config);
+}
+
+static int edfQuantum(const Process *process, const PolicyConfig *config) {
+    (void)process;
+    (void)config;
+    return INT_MAX;
+}
+
+static int edfPreempts(const Process *a, const Process *b, const PolicyConfig *config) {
+    return edfDeadline(a, config) < edfDeadline(b, config);
+}
+
+// Hooks of every policy, indexed by POLICY_ value
+static const SchedulingPolicy policies[] = {
+    {"tiered", 1, NULL, tieredQueueKey, tieredQuantum, tieredPreempts, tieredSliceEnd},
+    {"mlfq", 3, NULL, mlfqQueueKey, mlfqQuantum, mlfqPreempts, NULL},
+    {"cfs", 1, cfsArrival, cfsQueueKey, cfsQuantum, cfsPreempts, cfsSliceEnd},
+    {"edf", 1, NULL, edfQueueKey, edfQuantum, edfPreempts, NULL}
+};
+
+// Function to check that config selects a known policy
+static int checkPolicy(const PolicyConfig *config) {
+    if (config->policy < POLICY_TIERED || config->policy > POLICY_EDF) {
+        fprintf(stderr, "Unknown scheduling policy %d\n", config->policy);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to get the hooks of the policy selected by config
+static const SchedulingPolicy *schedulingPolicy(const PolicyConfig *config) {
+    return &policies[config->policy];
+}
+
+const char *policyName(int policy) {
+    return policy >= POLICY_TIERED && policy <= POLICY_EDF ? policies[policy].name : "unknown";
+}
+
+int policyByName(const char *name) {
+    for (int policy = POLICY_TIERED; policy <= POLICY_EDF; policy++) {
+        if (strcmp(name, policies[policy].name) == 0) {
+            return policy;
+        }
+    }
+    return -1;
+}
+
+// Function to grow the buffers of a queue to hold capacity processes; queued entries are kept
+// slots added by growing are marked as not queued
+static int reserveReadyQueue(ReadyQueue *queue, int capacity) {
+    if (capacity <= queue->capacity) {
+        return 0;
+    }
+
+    int *position = realloc(queue->position, capacity * sizeof(int));
+    if (position == NULL) {
+        return -1;
+    }
+    queue->position = position;
+    for (int i = queue->capacity; i < capacity; i++) {
+        queue->position[i] = -1;
+    }
+
+    long *sequence = realloc(queue->sequence, capacity * sizeof(long));
+    if (sequence == NULL) {
+        return -1;
+    }
+    queue->sequence = sequence;
+
+    for (int t = 0; t < 3; t++) {
+        ProcessHeap *heap = &queue->classes[t];
+        long long *key = realloc(heap->key, capacity * sizeof(long long));
+        if (key == NULL) {
+            return -1;
+        }
+        heap->key = key;
+
+        long *heapSequence = realloc(heap->sequence, capacity * sizeof(long));
+        if (heapSequence == NULL) {
+            return -1;
+        }
+        heap->sequence = heapSequence;
+
+        int *index = realloc(heap->index, capacity * sizeof(int));
+        if (index == NULL) {
+            return -1;
+        }
+        heap->index = index;
+    }
+    queue->capacity = capacity;
+    return 0;
+}
+
+// Function to size one heap per class for num_processes and empty them for a run under config
+// processes is the array the heaps index into; buffers of a zeroed queue are allocated, later grown
+static int initReadyQueue(ReadyQueue *queue, Process processes[], int num_processes, const PolicyConfig *config) {
+    if (reserveReadyQueue(queue, num_processes) == -1) {
+        return -1;
+    }
+
+    queue->processes = processes;
+    queue->policy = schedulingPolicy(config);
+    queue->config = config;
+    queue->floor = 0;
+    queue->nextSequence = 0;
+    queue->selections = 0;
+    queue->pushes = 0;
+    queue->pops = 0;
+    for (int t = 0; t < 3; t++) {
+        queue->classes[t].size = 0;
+    }
+    // clear every slot, not just num_processes: streamed runs pass 0 and reuse slots left by an earlier run
+    for (int i = 0; i < queue->capacity; i++) {
+        queue->position[i] = -1;
+        queue->sequence[i] = 0;
+    }
+    return 0;
+}
+
+static void freeReadyQueue(ReadyQueue *queue) {
+    free(queue->position);
+    free(queue->sequence);
+    for (int t = 0; t < 3; t++) {
+        free(queue->classes[t].key);
+        free(queue->classes[t].sequence);
+        free(queue->classes[t].index);
+        memset(&queue->classes[t], 0, sizeof(queue->classes[t]));
+    }
+    queue->position = NULL;
+    queue->sequence = NULL;
+    queue->capacity = 0;
+}
+
+// Function to order two heap entries: smaller key first, then FIFO by enqueue sequence
+static int heapBefore(const ProcessHeap *heap, int i, int j) {
+    if (heap->key[i] != heap->key[j]) {
+        return heap->key[i] < heap->key[j];
+    }
+    return heap->sequence[i] < heap->sequence[j];
+}
+
+// Function to find the best of the count (1..HEAP_ARITY) children starting at heap slot first
+static int bestChild(const ProcessHeap *heap, int first, int count) {
+    int best = first;
+    for (int c = first + 1; c < first + count; c++) {
+        if (heapBefore(heap, c, best)) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Function to store an entry at heap slot i and record where its process now sits
+static void heapPlace(ReadyQueue *queue, ProcessHeap *heap, int i, long long key, long sequence, int index) {
+    heap->key[i] = key;
+    heap->sequence[i] = sequence;
+    heap->index[i] = index;
+    queue->position[index] = i;
+}
+
+// Function to move the entry at slot i up until its parent comes before it
+static void heapSiftUp(ReadyQueue *queue, ProcessHeap *heap, int i) {
+    long long key = heap->key[i];
+    long sequence = heap->sequence[i];
+    int index = heap->index[i];
+
+    while (i > 0) {
+        int parent = (i - 1) / HEAP_ARITY;
+        if (heap->key[parent] < key || (heap->key[parent] == key && heap->sequence[parent] < sequence)) {
+            break;
+        }
+        heapPlace(queue, heap, i, heap->key[parent], heap->sequence[parent], heap->index[parent]);
+        i = parent;
+    }
+    heapPlace(queue, heap, i, key, sequence, index);
+}
+
+// Function to move the entry at slot i down until it comes before all of its children
+static void heapSiftDown(ReadyQueue *queue, ProcessHeap *heap, int i) {
+    long long key = heap->key[i];
+    long sequence = heap->sequence[i];
+    int index = heap->index[i];
+
+    for (;;) {
+        int first = HEAP_ARITY * i + 1;
+        if (first >= heap->size) {
+            break;
+        }
+        int count = heap->size - first < HEAP_ARITY ? heap->size - first : HEAP_ARITY;
+        int child = bestChild(heap, first, count);
+        if (heap->key[child] > key || (heap->key[child] == key && heap->sequence[child] > sequence)) {
+            break;
+        }
+        heapPlace(queue, heap, i, heap->key[child], heap->sequence[child], heap->index[child]);
+        i = child;
+    }
+    heapPlace(queue, heap, i, key, sequence, index);
+}
+
+// Function to put a process back into the heap of its current class, keeping its sequence number
+static void requeueProcess(ReadyQueue *queue, int index) {
+    int queueClass;
+    long long key;
+
+    queue->policy->queue_key(&queue->processes[index], queue->config, &queueClass, &key);
+    ProcessHeap *heap = &queue->classes[queueClass];
+    PROFILE_COUNT(queue->pushes, 1);
+    heapPlace(queue, heap, heap->size, key, queue->sequence[index], index);
+    heap->size++;
+    heapSiftUp(queue, heap, heap->size - 1);
+}
+
+// Function to enqueue an arrival, after the policy has set up its state
+static void admitProcess(ReadyQueue *queue, int index) {
+    if (queue->policy->on_arrival != NULL) {
+        queue->policy->on_arrival(&queue->processes[index], queue->floor, queue->config);
+    }
+    enqueueProcess(queue, index);
+}
+
+// Function to enqueue a process behind every queued process of the same key (round robin)
+static void enqueueProcess(ReadyQueue *queue, int index) {
+    queue->sequence[index] = queue->nextSequence++;
+    requeueProcess(queue, index);
+}
+
+// Function to remove a queued process from the heap of the given class
+static void removeQueuedProcess(ReadyQueue *queue, int index, int queueClass) {
+    ProcessHeap *heap = &queue->classes[queueClass];
+    int slot = queue->position[index];
+
+    PROFILE_COUNT(queue->pops, 1);
+    heap->size--;
+    queue->position[index] = -1;
+    if (slot != heap->size) {
+        // the last entry fills the hole and moves whichever way restores the order
+        int last = heap->size;
+        int moved = heap->index[last];
+        heapPlace(queue, heap, slot, heap->key[last], heap->sequence[last], moved);
+        heapSiftDown(queue, heap, slot);
+        heapSiftUp(queue, heap, queue->position[moved]);
+    }
+}
+
+// Function to pop the next process to dispatch: the head of the first non-empty strict class,
+// otherwise the best head of the remaining classes (tiered: platinum first, then the better of gold and silver)
+static int dequeueNextProcess(ReadyQueue *queue) {
+    ProcessHeap *chosen = NULL;
+    int chosenClass = -1;
+
+    PROFILE_COUNT(queue->selections, 1);
+    for (int c = 0; c < 3; c++) {
+        ProcessHeap *heap = &queue->classes[c];
+        if (heap->size == 0) {
+            continue;
+        }
+        if (chosen == NULL || heap->key[0] < chosen->key[0] ||
+            (heap->key[0] == chosen->key[0] && heap->sequence[0] < chosen->sequence[0])) {
+            chosen = heap;
+            chosenClass = c;
+        }
+        if (c < queue->policy->strict_classes) {
+            break;
+        }
+    }
+    if (chosen == NULL) {
+        return -1;
+    }
+
+    int selected = chosen->index[0];
+    queue->floor = chosen->key[0];
+    removeQueuedProcess(queue, selected, chosenClass);
+    return selected;
+}
+
+// Function to fill in the details of a definition from its program (PX.txt)
+static void startProcess(Process *process, const Process *program) {
+    //priority,type,arrival time, and id is from definition.txt
+    //rem time, burst time from all processes (PX.txt definitions)
+    process->remaining_time = program->remaining_time;
+    process->burst_time = program->burst_time;
+    process->completed = 0;  // Not completed
+    process->instruction_index = 0; //starting from first instruction
+    process->instruction_offset = program->instruction_offset;
+    process->instruction_count = program->instruction_count;
+    process->first_run = -1;
+    process->context_switches = 0;
+    process->preemptions = 0;
+    process->original_type = process->type;
+    process->ready_time = process->arrival_time;
+    process->last_cpu = -1;
+    process->vruntime = 0;
+}
+
+// Function to grow the process slots of a context, together with the ready queue that indexes them
+static int growContextSlots(SchedulerContext *context, int capacity) {
+    Process *processes = realloc(context->processes, capacity * sizeof(Process));
+    if (processes == NULL) {
+        return -1;
+    }
+    context->processes = processes;
+
+    int *freeSlots = realloc(context->free_slots, capacity * sizeof(int));
+    if (freeSlots == NULL) {
+        return -1;
+    }
+    context->free_slots = freeSlots;
+
+    if (reserveReadyQueue(&context->readyQueue, capacity) == -1) {
+        return -1;
+    }
+    context->readyQueue.processes = processes;
+    for (int c = 0; c < context->num_cpu_queues; c++) {
+        if (reserveReadyQueue(&context->cpu_queues[c], capacity) == -1) {
+            return -1;
+        }
+        context->cpu_queues[c].processes = processes;
+    }
+    context->capacity = capacity;
+    return 0;
+}
+
+// Function to get a free process slot for a streamed arrival, reusing slots of completed processes
+static int allocateSlot(SchedulerContext *context) {
+    if (context->num_free > 0) {
+        return context->free_slots[--context->num_free];
+    }
+    if (context->num_slots == context->capacity &&
+        growContextSlots(context, context->capacity > 0 ? 2 * context->capacity : 64) == -1) {
+        perror("Error allocating scheduler state");
+        return -1;
+    }
+    return context->num_slots++;
+}
+
+// Function to give back the slot of a completed process (streamed runs only)
+static void releaseSlot(SchedulerContext *context, const ArrivalSource *source, int slot) {
+    if (source->input != NULL) {
+        context->free_slots[context->num_free++] = slot;
+    }
+}
+
+// Function to add the process of slot, completed at currentTime on cpu, to the results
+static void recordCompletion(SchedulerContext *context, ScheduleResults *results, const ArrivalSource *source, const PolicyConfig *config,
+                      int slot, int currentTime, int cpu) {
+    const Process *process = &context->processes[slot];
+    int turnaround = currentTime - process->arrival_time;
+    int waiting = turnaround - process->burst_time;
+
+    if (context->recorder != NULL) {
+        recordEvent(context->recorder, EVENT_COMPLETE, currentTime, 0, process, cpu);
+        recordProcessMetrics(context->recorder, process, currentTime);
+    }
+    ScheduleStats *stats = &results->type_stats[(process->original_type - 1) * 3 + process->type - 1];
+    addMetricSample(&stats->waiting, waiting);
+    addMetricSample(&stats->turnaround, turnaround);
+    addMetricSample(&stats->response, process->first_run - process->arrival_time);
+    if (source->input == NULL && results->per_process) {
+        // batch slots are definition indices
+        results->turnaround_times[slot] = turnaround;
+        results->waiting_times[slot] = waiting;
+    }
+    results->num_completed++;
+    results->total_turnaround += turnaround;
+    results->total_waiting += waiting;
+    results->total_response += process->first_run - process->arrival_time;
+    if (currentTime > results->makespan) {
+        results->makespan = currentTime;
+    }
+    if (turnaround > config->deadlines[process->original_type - 1]) {
+        results->deadline_misses++;
+    }
+}
+
+// Function to read the next definition of a stream into the read-ahead buffer, returns 0 at end of input
+static int readStreamArrival(ArrivalSource *source) {
+    for (;;) {
+        ssize_t length = getline(&source->line_buffer, &source->line_capacity, source->input);
+        if (length == -1) {
+            if (ferror(source->input)) {
+                fprintf(stderr, "Error reading %s: %s\n", source->name, strerror(errno));
+                source->failed = 1;
+            }
+            source->exhausted = 1;
+            return 0;
+        }
+        source->line++;
+
+        Tokenizer tok;
+        tok.pos = source->line_buffer;
+        tok.end = source->line_buffer + length;
+        tok.line_start = source->line_buffer;
+        tok.line = source->line;
+        tok.filename = source->name;
+        if (!nextLine(&tok)) {
+            continue;  // blank line
+        }
+
+        Process process;
+        if (parseDefinitionLine(&tok, &process) == -1) {
+            source->failed = 1;
+            return 0;
+        }
+        if (process.id < 1 || process.id > source->library->num_programs ||
+            source->library->programs[process.id - 1].instruction_count == 0) {
+            fprintf(stderr, "%s:%d: no program P%d.txt in the library\n", source->name, source->line, process.id);
+            source->failed = 1;
+            return 0;
+        }
+        if (process.arrival_time < source->last_arrival) {
+            fprintf(stderr, "%s:%d: arrival times must not decrease\n", source->name, source->line);
+            source->failed = 1;
+            return 0;
+        }
+        source->last_arrival = process.arrival_time;
+        process.input_index = source->num_read++;
+
+        if (source->pending_count == source->pending_capacity) {
+            int capacity = source->pending_capacity > 0 ? 2 * source->pending_capacity : 64;
+            Process *pending = malloc(capacity * sizeof(Process));
+            if (pending == NULL) {
+                perror("Error allocating read-ahead buffer");
+                source->failed = 1;
+                return 0;
+            }
+            // unwrap the ring into the new buffer
+            for (int k = 0; k < source->pending_count; k++) {
+                pending[k] = source->pending[(source->pending_head + k) % source->pending_capacity];
+            }
+            free(source->pending);
+            source->pending = pending;
+            source->pending_head = 0;
+            source->pending_capacity = capacity;
+        }
+        source->pending[(source->pending_head + source->pending_count) % source->pending_capacity] = process;
+        source->pending_count++;
+        return 1;
+    }
+}
+
+// Function to look at the k-th arrival not admitted yet, NULL when there are no more
+static const Process *peekArrival(ArrivalSource *source, int k) {
+    if (source->input == NULL) {
+        return source->next + k < source->count ? source->sorted[source->next + k] : NULL;
+    }
+    while (source->pending_count <= k && !source->exhausted && !source->failed) {
+        readStreamArrival(source);
+    }
+    if (k >= source->pending_count) {
+        return NULL;
+    }
+    return &source->pending[(source->pending_head + k) % source->pending_capacity];
+}
+
+// Function to order streamed definitions that arrive at the same time by id, as a batch run would
+// Streams are already in arrival order, so only runs of equal arrival times are sorted
+static void orderStreamArrivals(ArrivalSource *source, int currentTime) {
+    int ready = 0;
+    int sorted = 1;
+    const Process *next;
+
+    while ((next = peekArrival(source, ready)) != NULL && next->arrival_time <= currentTime) {
+        if (ready > 0 && compareStreamedArrival(peekArrival(source, ready - 1), next) > 0) {
+            sorted = 0;
+        }
+        ready++;
+    }
+    if (sorted) {
+        return;
+    }
+
+    // unwrap the ring so the ready prefix is contiguous, then sort it in place
+    if (source->pending_head + ready > source->pending_capacity) {
+        Process *pending = malloc(source->pending_capacity * sizeof(Process));
+        if (pending == NULL) {
+            perror("Error allocating read-ahead buffer");
+            source->failed = 1;
+            return;
+        }
+        for (int k = 0; k < source->pending_count; k++) {
+            pending[k] = source->pending[(source->pending_head + k) % source->pending_capacity];
+        }
+        free(source->pending);
+        source->pending = pending;
+        source->pending_head = 0;
+    }
+    qsort(&source->pending[source->pending_head], ready, sizeof(Process), compareStreamedArrival);
+}
+
+// Function to take the next arrival out of source and start it in a process slot, returns the slot or -1
+static int takeArrival(SchedulerContext *context, ArrivalSource *source, const Workload *workload) {
+    int slot;
+
+    if (source->input == NULL) {
+        slot = (int)(source->sorted[source->next++] - context->processes);
+    } else {
+        slot = allocateSlot(context);
+        if (slot == -1) {
+            return -1;
+        }
+        context->processes[slot] = source->pending[source->pending_head];
+        source->pending_head = (source->pending_head + 1) % source->pending_capacity;
+        source->pending_count--;
+    }
+
+    Process *process = &context->processes[slot];
+    startProcess(process, &workload->programs[process->id - 1]);
+    if (source->input == NULL) {
+        process->input_index = slot;
+    }
+    if (context->recorder != NULL) {
+        recordEvent(context->recorder, EVENT_ARRIVAL, process->arrival_time, 0, process, -1);
+    }
+    return slot;
+}
+
+// Function to move every arrival up to currentTime into the ready queue, returns how many or -1
+static int admitArrivals(SchedulerContext *context, ArrivalSource *source, const Workload *workload, int currentTime) {
+    int admitted = 0;
+    const Process *next;
+
+    if (source->input != NULL) {
+        orderStreamArrivals(source, currentTime);
+    }
+
+    while ((next = peekArrival(source, 0)) != NULL && next->arrival_time <= currentTime) {
+        int slot = takeArrival(context, source, workload);
+        if (slot == -1) {
+            return -1;
+        }
+        admitProcess(&context->readyQueue, slot);
+        admitted++;
+    }
+    return admitted;
+}
+
+// Function to append size bytes to a snapshot buffer
+static int appendCheckpoint(CheckpointBuffer *buffer, const void *data, size_t size) {
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 65536;
+        while (capacity < buffer->size + size) {
+            capacity *= 2;
+        }
+        unsigned char *grown = realloc(buffer->data, capacity);
+        if (grown == NULL) {
+            perror("Error allocating checkpoint");
+            return -1;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    if (size > 0) {
+        memcpy(buffer->data + buffer->size, data, size);
+    }
+    buffer->size += size;
+    return 0;
+}
+
+// Function to read the next size bytes of a snapshot, -1 when it is truncated
+static int readCheckpoint(const MappedFile *file, size_t *offset, void *data, size_t size) {
+    if (file->size - *offset < size) {
+        fprintf(stderr, "Truncated checkpoint\n");
+        return -1;
+    }
+    memcpy(data, file->data + *offset, size);
+    *offset += size;
+    return 0;
+}
+
+// Function to get ready queue q of a run under config: one per CPU under per-core balancing
+static ReadyQueue *engineQueue(SchedulerContext *context, const PolicyConfig *config, int q) {
+    return config->num_cpus > 1 && config->balance != BALANCE_GLOBAL ? &context->cpu_queues[q] : &context->readyQueue;
+}
+
+// Worker of the background snapshot writer: writes the buffer to a temporary file, then renames it into place
+static void *checkpointWriter(void *argument) {
+    SchedulerContext *context = argument;
+    char temporary[sizeof(context->checkpoint_path) + 4];
+
+    snprintf(temporary, sizeof(temporary), "%s.tmp", context->checkpoint_path);
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", temporary, strerror(errno));
+        atomic_store(&context->checkpoint_failed, 1);
+        return NULL;
+    }
+
+    size_t written = fwrite(context->checkpoint.data, 1, context->checkpoint.size, file);
+    if (fclose(file) != 0 || written != context->checkpoint.size || rename(temporary, context->checkpoint_path) != 0) {
+        fprintf(stderr, "Error writing checkpoint %s\n", context->checkpoint_path);
+        unlink(temporary);
+        atomic_store(&context->checkpoint_failed, 1);
+    }
+    return NULL;
+}
+
+// Function to wait for the snapshot being written, returns -1 if any snapshot of the run failed
+static int finishCheckpoints(SchedulerContext *context) {
+    if (context->writer_active) {
+        pthread_join(context->checkpoint_writer, NULL);
+        context->writer_active = 0;
+    }
+    return atomic_exchange(&context->checkpoint_failed, 0) ? -1 : 0;
+}
+
+// Function to schedule the first snapshot of a run after currentTime
+static void startCheckpoints(SchedulerContext *context, int currentTime) {
+    if (context->checkpoint_interval > 0) {
+        context->next_checkpoint = (currentTime / context->checkpoint_interval + 1) * context->checkpoint_interval;
+    }
+}
+
+/*
+ * Function to snapshot a run between two steps of an engine and hand it to the writer thread.
+ * Copying the live state into memory is all the engine waits for, unless the previous snapshot
+ * is still being written. Only live processes are saved: batch definitions not yet admitted are
+ * rebuilt from the workload, streamed ones are read again from the saved input offset.
+ */
+static int takeCheckpoint(SchedulerContext *context, const ArrivalSource *source, const PolicyConfig *config,
+                   const ScheduleResults *results, int currentTime, int live, int lastRun) {
+    CheckpointBuffer *buffer = &context->checkpoint;
+    CheckpointHeader header;
+    int streamed = source->input != NULL;
+    int numQueues = config->num_cpus > 1 && config->balance != BALANCE_GLOBAL ? config->num_cpus : 1;
+    int numCpuStates = config->num_cpus > 1 ? config->num_cpus : 0;
+
+    if (finishCheckpoints(context) == -1) {
+        return -1;
+    }
+    startCheckpoints(context, currentTime);
+    if (snprintf(context->checkpoint_path, sizeof(context->checkpoint_path), "%s-%d.ckpt",
+                 context->checkpoint_prefix, currentTime) >= (int)sizeof(context->checkpoint_path)) {
+        fprintf(stderr, "Checkpoint prefix too long\n");
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = TRACE_BYTE_ORDER;
+    header.process_size = sizeof(Process);
+    header.time = currentTime;
+    header.num_cpus = config->num_cpus;
+    header.balance = config->balance;
+    header.streamed = streamed;
+    header.live = live;
+    header.last_run = lastRun;
+    header.num_definitions = streamed ? 0 : source->count;
+    header.next_arrival = source->next;
+    header.num_slots = context->num_slots;
+    header.num_free = streamed ? context->num_free : 0;
+    header.num_read = source->num_read;
+    header.line = source->line;
+    header.last_arrival = source->last_arrival;
+    header.exhausted = source->exhausted;
+    header.num_pending = source->pending_count;
+    header.input_offset = streamed ? ftello(source->input) : 0;
+    header.num_queues = numQueues;
+    header.per_process = results->per_process && !streamed;
+    header.num_cores = results->num_cores;
+    header.num_completed = results->num_completed;
+    header.total_turnaround = results->total_turnaround;
+    header.total_waiting = results->total_waiting;
+    header.total_response = results->total_response;
+    header.total_context_switches = results->total_context_switches;
+    header.num_dispatches = results->num_dispatches;
+    header.migrations = results->migrations;
+    header.deadline_misses = results->deadline_misses;
+    header.peak_live = results->peak_live;
+    header.makespan = results->makespan;
+    if (streamed && header.input_offset == -1) {
+        fprintf(stderr, "Checkpoints need a seekable stream: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // live processes: admitted and not completed
+    buffer->size = 0;
+    int scanned = streamed ? context->num_slots : source->next;
+    header.num_live_processes = 0;
+    int failed = appendCheckpoint(buffer, &header, sizeof(header));
+    for (int i = 0; i < scanned && failed == 0; i++) {
+        int slot = streamed ? i : (int)(source->sorted[i] - context->processes);
+        if (!context->processes[slot].completed) {
+            failed = appendCheckpoint(buffer, &slot, sizeof(slot)) | appendCheckpoint(buffer, &context->processes[slot], sizeof(Process));
+            header.num_live_processes++;
+        }
+    }
+    if (failed == 0 && header.num_free > 0) {
+        failed = appendCheckpoint(buffer, context->free_slots, header.num_free * sizeof(int));
+    }
+    for (int k = 0; k < source->pending_count && failed == 0; k++) {
+        failed = appendCheckpoint(buffer, &source->pending[(source->pending_head + k) % source->pending_capacity], sizeof(Process));
+    }
+
+    // ready queues as (slot, sequence) pairs; resuming requeues them under its own policy
+    for (int q = 0; q < numQueues && failed == 0; q++) {
+        const ReadyQueue *queue = engineQueue(context, config, q);
+        int count = queuedCount(queue);
+        failed = appendCheckpoint(buffer, &queue->nextSequence, sizeof(queue->nextSequence)) |
+                 appendCheckpoint(buffer, &queue->floor, sizeof(queue->floor)) | appendCheckpoint(buffer, &count, sizeof(count));
+        for (int c = 0; c < 3 && failed == 0; c++) {
+            const ProcessHeap *heap = &queue->classes[c];
+            for (int i = 0; i < heap->size && failed == 0; i++) {
+                failed = appendCheckpoint(buffer, &heap->index[i], sizeof(int)) | appendCheckpoint(buffer, &heap->sequence[i], sizeof(long));
+            }
+        }
+    }
+
+    if (failed == 0 && numCpuStates > 0) {
+        failed = appendCheckpoint(buffer, context->cpus, numCpuStates * sizeof(Cpu));
+    }
+    if (failed == 0) {
+        failed = appendCheckpoint(buffer, results->type_stats, 9 * sizeof(ScheduleStats));
+    }
+    if (failed == 0 && header.num_cores > 0) {
+        failed = appendCheckpoint(buffer, results->cores, header.num_cores * sizeof(CoreStats));
+    }
+    if (failed == 0 && header.per_process) {
+        failed = appendCheckpoint(buffer, results->turnaround_times, source->count * sizeof(int)) |
+                 appendCheckpoint(buffer, results->waiting_times, source->count * sizeof(int));
+    }
+    if (failed != 0) {
+        return -1;
+    }
+    // the count of live processes is only known now
+    memcpy(buffer->data, &header, sizeof(header));
+
+    if (pthread_create(&context->checkpoint_writer, NULL, checkpointWriter, context) != 0) {
+        fprintf(stderr, "Error starting the checkpoint writer\n");
+        return -1;
+    }
+    context->writer_active = 1;
+    return 0;
+}
+
+// Function to load the snapshot of context->resume into a freshly initialized engine
+// lastRun may be NULL for engines that keep it per CPU
+static int restoreCheckpoint(SchedulerContext *context, ArrivalSource *source, const PolicyConfig *config,
+                      ScheduleResults *results, int *currentTime, int *live, int *lastRun) {
+    const MappedFile *file = context->resume;
+    CheckpointHeader header;
+    size_t offset = 0;
+    int streamed = source->input != NULL;
+
+    if (readCheckpoint(file, &offset, &header, sizeof(header)) == -1) {
+        return -1;
+    }
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION ||
+        header.byte_order != TRACE_BYTE_ORDER || header.process_size != sizeof(Process)) {
+        fprintf(stderr, "Not a checkpoint of this build\n");
+        return -1;
+    }
+    if (header.streamed != streamed || (!streamed && header.num_definitions != source->count)) {
+        fprintf(stderr, "The checkpoint was taken of a different input\n");
+        return -1;
+    }
+    if (header.num_cpus != config->num_cpus || (config->num_cpus > 1 && header.balance != config->balance) ||
+        (header.per_process == 0 && results->per_process && !streamed)) {
+        fprintf(stderr, "The checkpoint was taken with a different CPU count or balancing\n");
+        return -1;
+    }
+
+    if (streamed) {
+        if (header.num_slots > context->capacity && growContextSlots(context, header.num_slots) == -1) {
+            perror("Error allocating scheduler state");
+            return -1;
+        }
+        context->num_slots = header.num_slots;
+        for (int slot = 0; slot < header.num_slots; slot++) {
+            context->processes[slot].completed = 1;
+        }
+    } else {
+        if (header.next_arrival < 0 || header.next_arrival > source->count) {
+            fprintf(stderr, "Corrupt checkpoint\n");
+            return -1;
+        }
+        source->next = header.next_arrival;
+        for (int i = 0; i < source->next; i++) {
+            source->sorted[i]->completed = 1;
+        }
+    }
+
+    int limit = streamed ? header.num_slots : source->count;
+    for (int i = 0; i < header.num_live_processes; i++) {
+        int slot;
+        if (readCheckpoint(file, &offset, &slot, sizeof(slot)) == -1) {
+            return -1;
+        }
+        if (slot < 0 || slot >= limit) {
+            fprintf(stderr, "Corrupt checkpoint\n");
+            return -1;
+        }
+        if (readCheckpoint(file, &offset, &context->processes[slot], sizeof(Process)) == -1) {
+            return -1;
+        }
+    }
+
+    if (streamed) {
+        if (header.num_free < 0 || header.num_free > header.num_slots ||
+            readCheckpoint(file, &offset, context->free_slots, header.num_free * sizeof(int)) == -1) {
+            return -1;
+        }
+        context->num_free = header.num_free;
+
+        int capacity = header.num_pending > 64 ? header.num_pending : 64;
+        source->pending = malloc(capacity * sizeof(Process));
+        if (source->pending == NULL) {
+            perror("Error allocating read-ahead buffer");
+            return -1;
+        }
+        source->pending_capacity = capacity;
+        source->pending_head = 0;
+        source->pending_count = header.num_pending;
+        if (readCheckpoint(file, &offset, source->pending, header.num_pending * sizeof(Process)) == -1) {
+            return -1;
+        }
+        source->num_read = header.num_read;
+        source->line = header.line;
+        source->last_arrival = header.last_arrival;
+        source->exhausted = header.exhausted;
+        if (fseeko(source->input, header.input_offset, SEEK_SET) != 0) {
+            fprintf(stderr, "Error seeking %s: %s\n", source->name, strerror(errno));
+            return -1;
+        }
+    }
+
+    for (int q = 0; q < header.num_queues; q++) {
+        ReadyQueue *queue = engineQueue(context, config, q);
+        int count;
+        if (readCheckpoint(file, &offset, &queue->nextSequence, sizeof(queue->nextSequence)) == -1 ||
+            readCheckpoint(file, &offset, &queue->floor, sizeof(queue->floor)) == -1 ||
+            readCheckpoint(file, &offset, &count, sizeof(count)) == -1) {
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            int slot;
+            if (readCheckpoint(file, &offset, &slot, sizeof(slot)) == -1) {
+                return -1;
+            }
+            if (slot < 0 || slot >= limit || queue->position[slot] != -1) {
+                fprintf(stderr, "Corrupt checkpoint\n");
+                return -1;
+            }
+            if (readCheckpoint(file, &offset, &queue->sequence[slot], sizeof(long)) == -1) {
+                return -1;
+            }
+            requeueProcess(queue, slot);
+        }
+    }
+
+    if (config->num_cpus > 1 && readCheckpoint(file, &offset, context->cpus, config->num_cpus * sizeof(Cpu)) == -1) {
+        return -1;
+    }
+    if (readCheckpoint(file, &offset, results->type_stats, 9 * sizeof(ScheduleStats)) == -1) {
+        return -1;
+    }
+    if (header.num_cores != results->num_cores) {
+        fprintf(stderr, "Corrupt checkpoint\n");
+        return -1;
+    }
+    if (header.num_cores > 0 && readCheckpoint(file, &offset, results->cores, header.num_cores * sizeof(CoreStats)) == -1) {
+        return -1;
+    }
+    if (header.per_process && results->per_process &&
+        (readCheckpoint(file, &offset, results->turnaround_times, source->count * sizeof(int)) == -1 ||
+         readCheckpoint(file, &offset, results->waiting_times, source->count * sizeof(int)) == -1)) {
+        return -1;
+    }
+
+    results->num_completed = header.num_completed;
+    results->total_turnaround = header.total_turnaround;
+    results->total_waiting = header.total_waiting;
+    results->total_response = header.total_response;
+    results->total_context_switches = header.total_context_switches;
+    results->num_dispatches = header.num_dispatches;
+    results->migrations = header.migrations;
+    results->deadline_misses = header.deadline_misses;
+    results->peak_live = header.peak_live;
+    results->makespan = header.makespan;
+    *currentTime = header.time;
+    *live = header.live;
+    if (lastRun != NULL) {
+        *lastRun = header.last_run;
+    }
+    return 0;
+}
+
+void setCheckpointing(SchedulerContext *context, const char *prefix, int interval) {
+    context->checkpoint_prefix = prefix;
+    context->checkpoint_interval = prefix != NULL && interval > 0 ? interval : 0;
+}
+
+// Function to load a snapshot for the next run of context; the run continues it instead of starting at 0
+static int beginResume(SchedulerContext *context, const char *snapshot, MappedFile *file) {
+    if (mapFile(snapshot, file) == -1) {
+        return -1;
+    }
+    context->resume = file;
+    return 0;
+}
+
+int resumeWorkload(SchedulerContext *context, const Workload *workload, const char *snapshot,
+                   const PolicyConfig *config, ScheduleResults *results) {
+    MappedFile file;
+    if (beginResume(context, snapshot, &file) == -1) {
+        return -1;
+    }
+    int status = scheduleWorkload(context, workload, config, results);
+    context->resume = NULL;
+    unmapFile(&file);
+    return status;
+}
+
+int resumeStream(SchedulerContext *context, const Workload *library, FILE *input, const char *name, const char *snapshot,
+                 const PolicyConfig *config, ScheduleResults *results) {
+    MappedFile file;
+    if (beginResume(context, snapshot, &file) == -1) {
+        return -1;
+    }
+    int status = scheduleStream(context, library, input, name, config, results);
+    context->resume = NULL;
+    unmapFile(&file);
+    return status;
+}
+
+// Function to run the engine matching the CPU count of config; snapshots being written are finished before returning
+static int runEngine(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+              const PolicyConfig *config, ScheduleResults *results) {
+    int status;
+
+    if (config->num_cpus > 1) {
+        status = smpScheduling(context, source, workload, config, results);
+    } else {
+        results->num_cores = 0;
+        results->migrations = 0;
+        status = preemptivePriorityScheduling(context, source, workload, config, results);
+    }
+    int numQueues = config->num_cpus > 1 && config->balance != BALANCE_GLOBAL ? config->num_cpus : 1;
+    for (int q = 0; q < numQueues; q++) {
+        const ReadyQueue *queue = engineQueue(context, config, q);
+        results->profile.dispatch_decisions += queue->selections;
+        results->profile.queue_pushes += queue->pushes;
+        results->profile.queue_pops += queue->pops;
+    }
+    if (finishCheckpoints(context) == -1) {
+        return -1;
+    }
+    return status;
+}
+
+/*
+ * Discrete-event engine: time never advances one ms at a time. Each step either dispatches
+ * the head of the ready queue for one slice or jumps the clock to the next arrival.
+ * A slice ends at the earliest of completion, quantum expiry or the arrival of a process
+ * that preempts the running one; the policy of config decides the queue order, the quantum
+ * and preemption (tiered: platinum slices always run to completion).
+ * Instructions are atomic: a quantum ends at the last instruction boundary that fits in it
+ * (an instruction longer than the quantum still runs whole) and a preemption takes effect
+ * at the first boundary after the arrival. instruction_index records where to resume.
+ * A context switch is charged whenever the CPU switches to a different process,
+ * including the very first dispatch.
+ * Arrivals come from source; the workload is only read.
+ */
+static int preemptivePriorityScheduling(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+                                 const PolicyConfig *config, ScheduleResults *results) {
+    const InstructionPool *pool = &workload->pool;
+    const SchedulingPolicy *policy = schedulingPolicy(config);
+    ReadyQueue *readyQueue = &context->readyQueue;
+    EventRecorder *recorder = context->recorder;
+
+    int currentTime = 0;
+
+    int lastRun = -1;
+    int live = 0;
+
+    if (beginScheduleResults(results) == -1) {
+        return -1;
+    }
+    if (context->resume != NULL && restoreCheckpoint(context, source, config, results, &currentTime, &live, &lastRun) == -1) {
+        return -1;
+    }
+    if (recorder != NULL) {
+        resetEventRecorder(recorder);
+    }
+    startCheckpoints(context, currentTime);
+
+    // Main scheduling loop
+    for (;;) {
+        PROFILE_COUNT(results->profile.loop_iterations, 1);
+        if (context->checkpoint_interval > 0 && currentTime >= context->next_checkpoint &&
+            takeCheckpoint(context, source, config, results, currentTime, live, lastRun) == -1) {
+            return -1;
+        }
+
+        // Admit arrivals in (arrival, id) order so equal priorities start out FIFO by id
+        int admitted = admitArrivals(context, source, workload, currentTime);
+        if (admitted == -1) {
+            return -1;
+        }
+        live += admitted;
+        if (live > results->peak_live) {
+            results->peak_live = live;
+        }
+
+        int selectedProcess = dequeueNextProcess(readyQueue);
+
+        if (selectedProcess == -1) {
+            // No process is ready, jump to the next arrival
+            const Process *next = peekArrival(source, 0);
+            if (next == NULL) {
+                break;
+            }
+            PROFILE_COUNT(results->profile.idle_jumps, 1);
+            PROFILE_COUNT(results->profile.idle_skipped, next->arrival_time - currentTime);
+            currentTime = next->arrival_time;
+            continue;
+        }
+
+        Process *running = &context->processes[selectedProcess];
+
+        //context switch
+        if (selectedProcess != lastRun) {
+            if (recorder != NULL) {
+                recordEvent(recorder, EVENT_CONTEXT_SWITCH, currentTime, config->context_switch, running, 0);
+            }
+            currentTime += config->context_switch;
+            running->context_switches++;
+            results->total_context_switches++;
+            PROFILE_COUNT(results->profile.context_switches, 1);
+            PROFILE_COUNT(results->profile.switch_time, config->context_switch);
+            // on one CPU every live process waits out the switch
+            PROFILE_COUNT(results->profile.switch_delay, (long long)config->context_switch * live);
+        }
+        lastRun = selectedProcess;
+        if (running->first_run == -1) {
+            running->first_run = currentTime;
+        }
+        int quantumExpired;
+        int slice = plannedSlice(pool, running, config, &quantumExpired);
+
+        // Arrivals not yet seen at dispatch time may preempt the slice at an instruction boundary
+        for (int p = 0;; p++) {
+            const Process *arrival = peekArrival(source, p);
+            if (arrival == NULL || arrival->arrival_time >= currentTime + slice) {
+                break;
+            }
+            if (policy->preempts(arrival, running, config)) {
+                int cut = runUntilBoundary(pool, running, arrival->arrival_time - currentTime);
+                if (cut < slice) {
+                    slice = cut;
+                    quantumExpired = 0;
+                    PROFILE_COUNT(results->profile.platinum_preemptions, arrival->type == 1);
+                }
+                break;
+            }
+        }
+
+        if (checkSlice(running, slice) == -1) {
+            return -1;
+        }
+        if (recorder != NULL) {
+            recordEvent(recorder, EVENT_DISPATCH, currentTime, slice, running, 0);
+        }
+        results->num_dispatches++;
+        currentTime += slice;
+
+        int oldType = running->type;
+        if (finishSlice(pool, running, slice, config)) {
+            recordCompletion(context, results, source, config, selectedProcess, currentTime, 0);
+            releaseSlot(context, source, selectedProcess);
+            live--;
+            // the slot may be handed to a new arrival, which still needs its context switch
+            lastRun = -1;
+            continue;
+        }
+
+        if (!quantumExpired) {
+            running->preemptions++;
+            PROFILE_COUNT(results->profile.preemptions, 1);
+        }
+        PROFILE_COUNT(results->profile.promotions, running->type != oldType);
+        if (recorder != NULL) {
+            recordEvent(recorder, quantumExpired ? EVENT_QUANTUM_EXPIRED : EVENT_PREEMPT, currentTime, 0, running, 0);
+            if (running->type != oldType) {
+                recordEvent(recorder, EVENT_PROMOTE, currentTime, 0, running, 0);
+            }
+        }
+
+        // Arrivals up to now queue ahead of the process coming off the CPU
+        // (admitting may move the process array, running is not used past this point)
+        admitted = admitArrivals(context, source, workload, currentTime);
+        if (admitted == -1) {
+            return -1;
+        }
+        live += admitted;
+        if (live > results->peak_live) {
+            results->peak_live = live;
+        }
+
+        if (quantumExpired) {
+            //round robin: rotate behind every other process of the same priority
+            enqueueProcess(readyQueue, selectedProcess);
+        } else {
+            //preempted: keep its place among equal priorities
+            requeueProcess(readyQueue, selectedProcess);
+        }
+    }
+
+    if (source->failed) {
+        return -1;
+    }
+    if (recorder != NULL && recorder->failed) {
+        fprintf(stderr, "Error allocating the event log\n");
+        return -1;
+    }
+    calculateAverages(results);
+    return 0;
+}
+
+// Function to work out the slice a process gets when dispatched, before preemption
+// sets *quantumExpired when the slice ends on quantum expiry rather than completion
+static int plannedSlice(const InstructionPool *pool, const Process *running, const PolicyConfig *config, int *quantumExpired) {
+    int slice = running->remaining_time;
+
+    *quantumExpired = 0;
+    int quantum = schedulingPolicy(config)->quantum(running, config);
+    if (slice > quantum) {
+        slice = runnableWithin(pool, running, quantum);
+        if (slice == 0) {
+            slice = runUntilBoundary(pool, running, 1);
+        }
+        *quantumExpired = slice < running->remaining_time;
+    }
+    return slice;
+}
+
+// Function to reject a slice that would not move time forward, which only corrupt burst prefix sums produce
+// without it the engines would dispatch the same process at the same time forever
+static int checkSlice(const Process *running, int slice) {
+    if (slice <= 0 && running->remaining_time > 0) {
+        fprintf(stderr, "P%d got an empty slice with %d ms left, its burst times are inconsistent\n", running->id,
+                running->remaining_time);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to apply a finished slice to a process: progress, then the policy's accounting; returns 1 when it completed
+static int finishSlice(const InstructionPool *pool, Process *running, int slice, const PolicyConfig *config) {
+    running->remaining_time -= slice;
+    running->instruction_index = prefixUpperBound(&pool->burst_prefix[running->instruction_offset], running->instruction_index,
+                                                  running->instruction_count, executedTime(pool, running) + slice);
+    if (running->remaining_time == 0) {
+        running->completed = 1;
+        return 1;
+    }
+
+    const SchedulingPolicy *policy = schedulingPolicy(config);
+    if (policy->on_slice_end != NULL) {
+        policy->on_slice_end(running, slice, config);
+    }
+    return 0;
+}
+
+// Function to count the processes waiting in a ready queue
+static int queuedCount(const ReadyQueue *queue) {
+    return queue->classes[0].size + queue->classes[1].size + queue->classes[2].size;
+}
+
+// Function to make room for the per-CPU state and, for per-core balancing, one ready queue per CPU
+static int reserveCpus(SchedulerContext *context, int numCpus, int perCoreQueues) {
+    if (numCpus > context->cpus_capacity) {
+        Cpu *cpus = realloc(context->cpus, numCpus * sizeof(Cpu));
+        if (cpus == NULL) {
+            return -1;
+        }
+        context->cpus = cpus;
+        context->cpus_capacity = numCpus;
+    }
+
+    if (perCoreQueues && numCpus > context->num_cpu_queues) {
+        ReadyQueue *queues = realloc(context->cpu_queues, numCpus * sizeof(ReadyQueue));
+        if (queues == NULL) {
+            return -1;
+        }
+        memset(&queues[context->num_cpu_queues], 0, (numCpus - context->num_cpu_queues) * sizeof(ReadyQueue));
+        context->cpu_queues = queues;
+        context->num_cpu_queues = numCpus;
+    }
+    return 0;
+}
+
+// Function to make room for the per-core statistics of numCpus CPUs and clear them
+static int reserveCoreStats(ScheduleResults *results, int numCpus) {
+    if (numCpus > results->cores_capacity) {
+        CoreStats *cores = realloc(results->cores, numCpus * sizeof(CoreStats));
+        if (cores == NULL) {
+            return -1;
+        }
+        results->cores = cores;
+        results->cores_capacity = numCpus;
+    }
+    memset(results->cores, 0, numCpus * sizeof(CoreStats));
+    results->num_cores = numCpus;
+    results->migrations = 0;
+    return 0;
+}
+
+// Function to pick the ready queue of a CPU, the shared queue under global balancing
+static ReadyQueue *cpuQueue(SchedulerContext *context, const PolicyConfig *config, int cpu) {
+    return config->balance == BALANCE_GLOBAL ? &context->readyQueue : &context->cpu_queues[cpu];
+}
+
+// Function to choose the CPU whose queue an arriving process joins under per-core balancing
+// affinity pins each program to one CPU, work stealing starts a process on the least loaded CPU
+static int placeArrival(SchedulerContext *context, const PolicyConfig *config, const Process *process) {
+    if (config->balance == BALANCE_AFFINITY) {
+        return (process->id - 1) % config->num_cpus;
+    }
+
+    int best = 0;
+    int bestLoad = INT_MAX;
+    for (int c = 0; c < config->num_cpus; c++) {
+        int load = queuedCount(&context->cpu_queues[c]) + (context->cpus[c].running != -1);
+        if (load < bestLoad) {
+            best = c;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+// Function to cut the slice of a CPU at the first instruction boundary after time, for an arrival that outranks it
+// returns 1 when the slice got shorter
+static int preemptCpu(SchedulerContext *context, const InstructionPool *pool, Cpu *cpu, int time) {
+    const Process *running = &context->processes[cpu->running];
+    int cut = runUntilBoundary(pool, running, time - cpu->slice_start);
+
+    cpu->claimed = 1;
+    if (cpu->slice_start + cut < cpu->slice_end) {
+        cpu->slice_end = cpu->slice_start + cut;
+        cpu->quantum_expired = 0;
+        return 1;
+    }
+    return 0;
+}
+
+// Function to find the CPU an arrival preempts under global balancing, -1 for none
+// an arrival preempts only when every CPU is busy, and then the weakest process it outranks
+static int preemptionVictim(SchedulerContext *context, const PolicyConfig *config, const Process *arrival) {
+    const SchedulingPolicy *policy = schedulingPolicy(config);
+    int victim = -1;
+
+    for (int c = 0; c < config->num_cpus; c++) {
+        const Cpu *cpu = &context->cpus[c];
+        if (cpu->running == -1) {
+            return -1;
+        }
+        if (cpu->claimed || !policy->preempts(arrival, &context->processes[cpu->running], config)) {
+            continue;
+        }
+        if (victim == -1 || policy->preempts(&context->processes[context->cpus[victim].running], &context->processes[cpu->running], config)) {
+            victim = c;
+        }
+    }
+    return victim;
+}
+
+// Function to take the CPU's next process: its own queue first, then under work stealing
+// the head of the longest other queue; returns the slot or -1
+static int takeNextProcess(SchedulerContext *context, const PolicyConfig *config, int cpu, int *stolen) {
+    int selected = dequeueNextProcess(cpuQueue(context, config, cpu));
+
+    *stolen = 0;
+    if (selected != -1 || config->balance != BALANCE_STEAL) {
+        return selected;
+    }
+
+    int victim = -1;
+    int longest = 0;
+    for (int c = 0; c < config->num_cpus; c++) {
+        int length = queuedCount(&context->cpu_queues[c]);
+        if (c != cpu && length > longest) {
+            victim = c;
+            longest = length;
+        }
+    }
+    if (victim == -1) {
+        return -1;
+    }
+    *stolen = 1;
+    return dequeueNextProcess(&context->cpu_queues[victim]);
+}
+
+/*
+ * Multi-CPU version of the discrete-event engine. Each CPU runs one slice at a time;
+ * the clock jumps to the earliest slice end or arrival. At each instant, slices that end
+ * are applied first, then arrivals are admitted (possibly cutting a running slice at its
+ * next instruction boundary), then the processes coming off a CPU are queued again, and
+ * finally idle CPUs dispatch in CPU order. A process dispatched on a different CPU than
+ * the one it last ran on pays migration_cost on top of the context switch.
+ * Balancing: BALANCE_GLOBAL shares one ready queue; BALANCE_STEAL gives every CPU its own
+ * queue and lets an idle CPU take the head of the longest queue; BALANCE_AFFINITY pins
+ * program X to CPU (X-1) mod num_cpus.
+ * Waiting before each dispatch (switch and migration included) is charged to the
+ * dispatching CPU under the process's original type.
+ */
+static int smpScheduling(SchedulerContext *context, ArrivalSource *source, const Workload *workload,
+                  const PolicyConfig *config, ScheduleResults *results) {
+    const InstructionPool *pool = &workload->pool;
+    const SchedulingPolicy *policy = schedulingPolicy(config);
+    EventRecorder *recorder = context->recorder;
+    int numCpus = config->num_cpus;
+    int perCore = config->balance != BALANCE_GLOBAL;
+
+    if (reserveCpus(context, numCpus, perCore) == -1 || reserveCoreStats(results, numCpus) == -1) {
+        perror("Error allocating scheduler state");
+        return -1;
+    }
+    if (perCore) {
+        for (int c = 0; c < numCpus; c++) {
+            if (initReadyQueue(&context->cpu_queues[c], context->processes, source->input == NULL ? source->count : 0, config) == -1 ||
+                reserveReadyQueue(&context->cpu_queues[c], context->capacity) == -1) {
+                perror("Error allocating scheduler state");
+                return -1;
+            }
+        }
+    }
+    for (int c = 0; c < numCpus; c++) {
+        Cpu *cpu = &context->cpus[c];
+        memset(cpu, 0, sizeof(*cpu));
+        cpu->running = -1;
+        cpu->last_run = -1;
+        cpu->finished = -1;
+    }
+
+    int currentTime = 0;
+    int live = 0;
+
+    if (beginScheduleResults(results) == -1) {
+        return -1;
+    }
+    if (context->resume != NULL && restoreCheckpoint(context, source, config, results, &currentTime, &live, NULL) == -1) {
+        return -1;
+    }
+    if (recorder != NULL) {
+        resetEventRecorder(recorder);
+    }
+    startCheckpoints(context, currentTime);
+
+    for (;;) {
+        PROFILE_COUNT(results->profile.loop_iterations, 1);
+        if (context->checkpoint_interval > 0 && currentTime >= context->next_checkpoint &&
+            takeCheckpoint(context, source, config, results, currentTime, live, -1) == -1) {
+            return -1;
+        }
+
+        // 1. apply the slices that end now; processes still running are queued again in step 3
+        for (int c = 0; c < numCpus; c++) {
+            Cpu *cpu = &context->cpus[c];
+            if (cpu->running == -1 || cpu->slice_end != currentTime) {
+                continue;
+            }
+
+            Process *running = &context->processes[cpu->running];
+            int oldType = running->type;
+            if (recorder != NULL) {
+                recordEvent(recorder, EVENT_DISPATCH, cpu->slice_start, cpu->slice_end - cpu->slice_start, running, c);
+            }
+            results->cores[c].busy_time += cpu->slice_end - cpu->slice_start;
+
+            if (finishSlice(pool, running, cpu->slice_end - cpu->slice_start, config)) {
+                int slot = cpu->running;
+                recordCompletion(context, results, source, config, slot, currentTime, c);
+                releaseSlot(context, source, slot);
+                live--;
+                // the slot may be handed to a new arrival, which still needs its context switch
+                for (int k = 0; k < numCpus; k++) {
+                    if (context->cpus[k].last_run == slot) {
+                        context->cpus[k].last_run = -1;
+                    }
+                }
+                cpu->running = -1;
+                cpu->finished = -1;
+                continue;
+            }
+
+            if (!cpu->quantum_expired) {
+                running->preemptions++;
+                PROFILE_COUNT(results->profile.preemptions, 1);
+            }
+            PROFILE_COUNT(results->profile.promotions, running->type != oldType);
+            if (recorder != NULL) {
+                recordEvent(recorder, cpu->quantum_expired ? EVENT_QUANTUM_EXPIRED : EVENT_PREEMPT, currentTime, 0, running, c);
+                if (running->type != oldType) {
+                    recordEvent(recorder, EVENT_PROMOTE, currentTime, 0, running, c);
+                }
+            }
+            running->ready_time = currentTime;
+            cpu->finished = cpu->running;
+            cpu->running = -1;
+        }
+
+        // 2. admit arrivals up to now in (arrival, id) order
+        if (source->input != NULL) {
+            orderStreamArrivals(source, currentTime);
+        }
+        const Process *next;
+        while ((next = peekArrival(source, 0)) != NULL && next->arrival_time <= currentTime) {
+            int slot = takeArrival(context, source, workload);
+            if (slot == -1) {
+                return -1;
+            }
+            Process *process = &context->processes[slot];
+            live++;
+
+            int target;
+            if (perCore) {
+                target = placeArrival(context, config, process);
+                Cpu *cpu = &context->cpus[target];
+                if (cpu->running != -1 && !cpu->claimed && policy->preempts(process, &context->processes[cpu->running], config)) {
+                    int cut = preemptCpu(context, pool, cpu, currentTime);
+                    PROFILE_COUNT(results->profile.platinum_preemptions, cut && process->type == 1);
+                }
+            } else {
+                target = preemptionVictim(context, config, process);
+                if (target != -1) {
+                    int cut = preemptCpu(context, pool, &context->cpus[target], currentTime);
+                    PROFILE_COUNT(results->profile.platinum_preemptions, cut && process->type == 1);
+                }
+            }
+            admitProcess(cpuQueue(context, config, perCore ? target : 0), slot);
+        }
+        if (live > results->peak_live) {
+            results->peak_live = live;
+        }
+
+        // 3. processes coming off a CPU queue behind the arrivals, on the CPU they ran on
+        for (int c = 0; c < numCpus; c++) {
+            Cpu *cpu = &context->cpus[c];
+            if (cpu->finished == -1) {
+                continue;
+            }
+            ReadyQueue *queue = cpuQueue(context, config, c);
+            if (cpu->quantum_expired || cpu->stolen) {
+                //round robin, or a stolen process that has no place in this queue yet
+                enqueueProcess(queue, cpu->finished);
+            } else {
+                //preempted: keep its place among equal priorities
+                requeueProcess(queue, cpu->finished);
+            }
+            cpu->finished = -1;
+        }
+
+        // 4. idle CPUs dispatch
+        for (int c = 0; c < numCpus; c++) {
+            Cpu *cpu = &context->cpus[c];
+            if (cpu->running != -1) {
+                continue;
+            }
+            int stolen;
+            int selected = takeNextProcess(context, config, c, &stolen);
+            if (selected == -1) {
+                continue;
+            }
+
+            Process *running = &context->processes[selected];
+            CoreStats *core = &results->cores[c];
+            int start = currentTime;
+
+            //context switch, and migration when the process last ran elsewhere
+            if (selected != cpu->last_run) {
+                if (recorder != NULL) {
+                    recordEvent(recorder, EVENT_CONTEXT_SWITCH, start, config->context_switch, running, c);
+                }
+                start += config->context_switch;
+                core->switch_time += config->context_switch;
+                running->context_switches++;
+                results->total_context_switches++;
+                PROFILE_COUNT(results->profile.context_switches, 1);
+            }
+            if (running->last_cpu != -1 && running->last_cpu != c) {
+                start += config->migration_cost;
+                core->switch_time += config->migration_cost;
+                core->migrations++;
+                results->migrations++;
+            }
+            PROFILE_COUNT(results->profile.switch_time, start - currentTime);
+            // the dispatched process and everything queued behind this CPU wait out the switch
+            PROFILE_COUNT(results->profile.switch_delay, (long long)(start - currentTime) * (1 + queuedCount(cpuQueue(context, config, c))));
+            running->last_cpu = c;
+            cpu->last_run = selected;
+            if (running->first_run == -1) {
+                running->first_run = start;
+            }
+
+            int tier = running->original_type - 1;
+            int waited = start - running->ready_time;
+            core->tier_waiting[tier] += waited;
+            core->tier_dispatches[tier]++;
+            if (waited > core->tier_max_waiting[tier]) {
+                core->tier_max_waiting[tier] = waited;
+            }
+
+            cpu->running = selected;
+            cpu->stolen = stolen;
+            cpu->claimed = 0;
+            cpu->slice_start = start;
+            int slice = plannedSlice(pool, running, config, &cpu->quantum_expired);
+            if (checkSlice(running, slice) == -1) {
+                return -1;
+            }
+            cpu->slice_end = start + slice;
+            results->num_dispatches++;
+        }
+
+        // 5. jump to the next slice end or arrival
+        int nextTime = INT_MAX;
+        int busy = 0;
+        for (int c = 0; c < numCpus; c++) {
+            if (context->cpus[c].running != -1) {
+                busy = 1;
+                if (context->cpus[c].slice_end < nextTime) {
+                    nextTime = context->cpus[c].slice_end;
+                }
+            }
+        }
+        next = peekArrival(source, 0);
+        if (next != NULL && next->arrival_time < nextTime) {
+            nextTime = next->arrival_time;
+        }
+        if (!busy && next == NULL) {
+            break;
+        }
+        if (!busy) {
+            PROFILE_COUNT(results->profile.idle_jumps, 1);
+            PROFILE_COUNT(results->profile.idle_skipped, nextTime - currentTime);
+        }
+        currentTime = nextTime;
+    }
+
+    if (source->failed) {
+        return -1;
+    }
+    if (recorder != NULL && recorder->failed) {
+        fprintf(stderr, "Error allocating the event log\n");
+        return -1;
+    }
+    calculateAverages(results);
+    return 0;
+}
+
+// Function to fill in the built-in policy constants
+void defaultPolicyConfig(PolicyConfig *config) {
+    config->silver_quantum = 80;
+    config->gold_quantum = 120;
+    config->context_switch = 10;
+    config->silver_to_gold_threshold = 3 * 80;
+    config->gold_to_platinum_threshold = 5 * 120;
+    config->num_cpus = 1;
+    config->migration_cost = 5;
+    config->balance = BALANCE_GLOBAL;
+    config->policy = POLICY_TIERED;
+    config->deadlines[0] = 1000;
+    config->deadlines[1] = 4000;
+    config->deadlines[2] = 16000;
+}
+
+// Function to run worker(job) on num_threads threads, the calling thread being one of them
+// workers claim items from the job themselves; no more threads start than there are items,
+// and when pthread_create fails the threads already started and the caller share the work
+static int runWorkers(void *(*worker)(void *), void *job, int num_items, int num_threads) {
+    if (num_threads > num_items) {
+        num_threads = num_items;
+    }
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+
+    pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+    if (threads == NULL) {
+        perror("Error allocating worker threads");
+        return -1;
+    }
+
+    int started = 0;
+    for (; started < num_threads - 1; started++) {
+        if (pthread_create(&threads[started], NULL, worker, job) != 0) {
+            break;
+        }
+    }
+    worker(job);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    free(threads);
+    return 0;
+}
+
+// Worker of the sweep thread pool: claims configurations until none are left
+// the workload is shared read-only, each worker schedules its own copy of the definitions
+static void *sweepWorker(void *argument) {
+    SweepJob *job = argument;
+    SchedulerContext *context = createSchedulerContext();
+    ScheduleResults results = {0};
+
+    if (context == NULL) {
+        perror("Error allocating sweep worker");
+        atomic_store(&job->failed, 1);
+        return NULL;
+    }
+
+    for (;;) {
+        int c = atomic_fetch_add(&job->next, 1);
+        if (c >= job->num_configs) {
+            break;
+        }
+        if (scheduleWorkload(context, job->workload, &job->configs[c], &results) == -1) {
+            atomic_store(&job->failed, 1);
+            continue;
+        }
+        job->results[c] = results.averages;
+    }
+
+    freeScheduleResults(&results);
+    destroySchedulerContext(context);
+    return NULL;
+}
+
+// Function to schedule one workload under every configuration of the grid on num_threads threads
+int runSweep(const Workload *workload, const PolicyConfig configs[], int num_configs, ScheduleAverages results[], int num_threads) {
+    SweepJob job;
+    job.workload = workload;
+    job.configs = configs;
+    job.results = results;
+    job.num_configs = num_configs;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+
+    if (runWorkers(sweepWorker, &job, num_configs, num_threads) == -1) {
+        return -1;
+    }
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+// Function to check that every definition names a program of the library
+static int checkLibraryPrograms(const Workload *library, const ProcessTable *definitions, const char *filename) {
+    for (int i = 0; i < definitions->count; i++) {
+        int id = definitions->items[i].id;
+        if (id < 1 || id > library->num_programs || library->programs[id - 1].instruction_count == 0) {
+            fprintf(stderr, "%s: definition %d: no program P%d.txt in the library\n", filename, i + 1, id);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Worker of the batch thread pool: claims definition files until none are left
+// each worker reads its files into its own table and schedules them against the shared library
+static void *batchWorker(void *argument) {
+    BatchJob *job = argument;
+    SchedulerContext *context = createSchedulerContext();
+    ScheduleResults results = {0};
+    Workload scenario = *job->library;
+
+    if (context == NULL) {
+        perror("Error allocating batch worker");
+        atomic_store(&job->failed, 1);
+        return NULL;
+    }
+    memset(&scenario.definitions, 0, sizeof(scenario.definitions));
+
+    for (;;) {
+        int b = atomic_fetch_add(&job->next, 1);
+        if (b >= job->num_paths) {
+            break;
+        }
+        BatchResult *result = &job->results[b];
+        memset(result, 0, sizeof(*result));
+
+        scenario.definitions.count = 0;
+        if (readProcessesFromFile(job->paths[b], &scenario.definitions) == -1 ||
+            checkLibraryPrograms(job->library, &scenario.definitions, job->paths[b]) == -1 ||
+            scheduleWorkload(context, &scenario, job->config, &results) == -1) {
+            result->failed = 1;
+            atomic_store(&job->failed, 1);
+            continue;
+        }
+        result->num_processes = scenario.definitions.count;
+        result->averages = results.averages;
+    }
+
+    free(scenario.definitions.items);
+    freeScheduleResults(&results);
+    destroySchedulerContext(context);
+    return NULL;
+}
+
+// Function to schedule many definition files against one loaded program library on num_threads threads
+int runBatch(const Workload *library, const char *const paths[], int num_paths, const PolicyConfig *config,
+             BatchResult results[], int num_threads) {
+    BatchJob job;
+    job.library = library;
+    job.paths = paths;
+    job.config = config;
+    job.results = results;
+    job.num_paths = num_paths;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+
+    if (runWorkers(batchWorker, &job, num_paths, num_threads) == -1) {
+        return -1;
+    }
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+// Function to fill in the default replication settings
+void defaultReplicationConfig(ReplicationConfig *config) {
+    config->replications = 30;
+    config->seed = 1;
+    config->arrival_jitter = 10;
+    config->length_variation = 0.2;
+}
+
+// Function to build replication r of base into replica, using the buffers of the replica workload
+// arrivals move uniformly within +-jitter (never before 0), every instruction of every program
+// gets a length scaled uniformly within 1 +- variation; the instruction ids stay shared with base
+static int buildReplica(const Workload *base, const ReplicationConfig *config, int r, Workload *replica, int *capacity) {
+    const InstructionPool *pool = &base->pool;
+    int n = base->definitions.count;
+    // splitmix64 streams of distinct seeds are independent, so each replication gets its own
+    uint64_t state = config->seed + (uint64_t)r * 0xD1B54A32D192ED03ull;
+
+    if (capacity[0] < n) {
+        Process *items = realloc(replica->definitions.items, n * sizeof(Process));
+        if (items == NULL) {
+            return -1;
+        }
+        replica->definitions.items = items;
+        capacity[0] = n;
+    }
+    if (capacity[1] < pool->count) {
+        int *prefix = realloc(replica->pool.burst_prefix, pool->count * sizeof(int));
+        if (prefix == NULL) {
+            return -1;
+        }
+        replica->pool.burst_prefix = prefix;
+        capacity[1] = pool->count;
+    }
+    if (capacity[2] < base->num_programs) {
+        Process *programs = realloc(replica->programs, base->num_programs * sizeof(Process));
+        if (programs == NULL) {
+            return -1;
+        }
+        replica->programs = programs;
+        capacity[2] = base->num_programs;
+    }
+
+    replica->num_programs = base->num_programs;
+    replica->pool.ids = pool->ids;
+    replica->pool.count = pool->count;
+    replica->definitions.count = n;
+
+    for (int i = 0; i < base->num_programs; i++) {
+        const Process *program = &base->programs[i];
+        const int *prefix = &pool->burst_prefix[program->instruction_offset];
+        int *sampled = &replica->pool.burst_prefix[program->instruction_offset];
+        int total = 0;
+
+        for (int k = 0; k < program->instruction_count; k++) {
+            int burst = prefix[k] - (k > 0 ? prefix[k - 1] : 0);
+            if (burst > 0) {
+                double scale = 1.0 + config->length_variation * (2.0 * randomUnit(&state) - 1.0);
+                int length = (int)lround(burst * scale);
+                burst = length > 1 ? length : 1;
+            }
+            total += burst;
+            sampled[k] = total;
+        }
+        replica->programs[i] = *program;
+        replica->programs[i].burst_time = total;
+        replica->programs[i].remaining_time = total;
+    }
+
+    for (int i = 0; i < n; i++) {
+        Process *process = &replica->definitions.items[i];
+        *process = base->definitions.items[i];
+        if (config->arrival_jitter > 0) {
+            int arrival = process->arrival_time + randomRange(&state, -config->arrival_jitter, config->arrival_jitter);
+            process->arrival_time = arrival > 0 ? arrival : 0;
+        }
+    }
+    return 0;
+}
+
+// Worker of the replication thread pool: claims replications until none are left
+// every worker owns its replica buffers, context and results; only the base workload is shared
+static void *replicationWorker(void *argument) {
+    static const double percentiles[3] = {0.50, 0.95, 0.99};
+    ReplicationJob *job = argument;
+    SchedulerContext *context = createSchedulerContext();
+    ScheduleResults results = {0};
+    ScheduleStats stats;
+    Workload replica;
+    int capacity[3] = {0, 0, 0};
+
+    memset(&replica, 0, sizeof(replica));
+    if (context == NULL) {
+        perror("Error allocating replication worker");
+        atomic_store(&job->failed, 1);
+        return NULL;
+    }
+
+    for (;;) {
+        int r = atomic_fetch_add(&job->next, 1);
+        if (r >= job->config->replications) {
+            break;
+        }
+        if (buildReplica(job->workload, job->config, r, &replica, capacity) == -1) {
+            perror("Error allocating replication");
+            atomic_store(&job->failed, 1);
+            continue;
+        }
+        if (scheduleWorkload(context, &replica, job->policy, &results) == -1) {
+            atomic_store(&job->failed, 1);
+            continue;
+        }
+
+        // per replication: average, p50, p95 and p99 of waiting, then of turnaround
+        double *metrics = &job->metrics[(size_t)r * REPLICATION_METRICS];
+        collectScheduleStats(&results, 0, 0, &stats);
+        metrics[0] = results.averages.avg_waiting;
+        metrics[4] = results.averages.avg_turnaround;
+        for (int q = 0; q < 3; q++) {
+            metrics[1 + q] = metricPercentile(&stats.waiting, percentiles[q]);
+            metrics[5 + q] = metricPercentile(&stats.turnaround, percentiles[q]);
+        }
+    }
+
+    free(replica.definitions.items);
+    free(replica.pool.burst_prefix);
+    free(replica.programs);
+    freeScheduleResults(&results);
+    destroySchedulerContext(context);
+    return NULL;
+}
+
+// Function to get the two-sided 95% critical value of Student's t with df degrees of freedom
+static double tCritical95(int df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) {
+        return 0.0;
+    }
+    if (df <= 30) {
+        return table[df - 1];
+    }
+    // Cornish-Fisher expansion around the normal quantile
+    double z = 1.959964;
+    return z + (z * z * z + z) / (4.0 * df) + (5 * pow(z, 5) + 16 * pow(z, 3) + 3 * z) / (96.0 * df * df);
+}
+
+// Function to summarize one metric over the replications: mean with its 95% confidence interval, spread
+static void summarizeMetric(const double *metrics, int stride, int count, MetricSummary *summary) {
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    summary->min = count > 0 ? metrics[0] : 0.0;
+    summary->max = summary->min;
+    for (int r = 0; r < count; r++) {
+        double value = metrics[(size_t)r * stride];
+        // Welford's update keeps the variance stable for large values
+        double delta = value - mean;
+        mean += delta / (r + 1);
+        m2 += delta * (value - mean);
+        if (value < summary->min) {
+            summary->min = value;
+        }
+        if (value > summary->max) {
+            summary->max = value;
+        }
+    }
+
+    summary->mean = mean;
+    summary->stddev = count > 1 ? sqrt(m2 / (count - 1)) : 0.0;
+    double half = count > 1 ? tCritical95(count - 1) * summary->stddev / sqrt(count) : 0.0;
+    summary->ci_low = mean - half;
+    summary->ci_high = mean + half;
+}
+
+// Function to run config->replications randomized replications of base on num_threads threads
+int runReplications(const Workload *base, const PolicyConfig *policy, const ReplicationConfig *config,
+                    int num_threads, ReplicationSummary *summary) {
+    if (config->replications < 1 || config->arrival_jitter < 0 || config->length_variation < 0.0 || config->length_variation >= 1.0) {
+        fprintf(stderr, "Replication settings out of range\n");
+        return -1;
+    }
+
+    ReplicationJob job;
+    job.workload = base;
+    job.policy = policy;
+    job.config = config;
+    job.metrics = malloc((size_t)config->replications * REPLICATION_METRICS * sizeof(double));
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+    if (job.metrics == NULL) {
+        perror("Error allocating replication results");
+        return -1;
+    }
+
+    if (runWorkers(replicationWorker, &job, config->replications, num_threads) == -1) {
+        free(job.metrics);
+        return -1;
+    }
+
+    summary->replications = config->replications;
+    for (int m = 0; m < 4; m++) {
+        summarizeMetric(&job.metrics[m], REPLICATION_METRICS, config->replications, &summary->waiting[m]);
+        summarizeMetric(&job.metrics[4 + m], REPLICATION_METRICS, config->replications, &summary->turnaround[m]);
+    }
+    free(job.metrics);
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+// Function to build directory/name into buffer; a NULL or empty directory means the current one
+static int joinPath(char *buffer, size_t size, const char *directory, const char *name) {
+    int length;
+
+    if (directory == NULL || directory[0] == '\0') {
+        length = snprintf(buffer, size, "%s", name);
+    } else {
+        length = snprintf(buffer, size, "%s/%s", directory, name);
+    }
+    if (length < 0 || (size_t)length >= size) {
+        fprintf(stderr, "Path too long: %s/%s\n", directory, name);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to hash file contents (FNV-1a, 64 bits)
+static uint64_t contentHash(const char *data, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t k = 0; k < size; k++) {
+        hash = (hash ^ (unsigned char)data[k]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Function to run the current phase of a program load for program i
+static int loadProgram(ProgramLoadJob *job, int i) {
+    char name[32];
+    char filename[4096];
+    snprintf(name, sizeof(name), "P%d.txt", i + 1);
+    if (joinPath(filename, sizeof(filename), job->directory, name) == -1) {
+        return -1;
+    }
+
+    if (job->phase == PROGRAM_MAP) {
+        if (mapFile(filename, &job->files[i]) == -1) {
+            return -1;
+        }
+        job->hashes[i] = contentHash(job->files[i].data, job->files[i].size);
+        return 0;
+    }
+
+    if (job->representative[i] != i) {
+        return 0;
+    }
+    InstructionPool *pool = &job->pools[i];
+    if (readInstructionsForProcessesFromFile(&job->files[i], filename, pool) == -1) {
+        return -1;
+    }
+    pool->burst_prefix = malloc(pool->count * sizeof(int));
+    if (pool->burst_prefix == NULL) {
+        perror("Error allocating burst prefix sums");
+        return -1;
+    }
+    //take the total of the instruction bursts (exit included) to determine process burst time.
+    job->bursts[i] = computeBurstPrefix(pool, 0, pool->count, job->catalog, filename);
+    return job->bursts[i] == -1 ? -1 : 0;
+}
+
+// Worker of the program load thread pool: claims wanted programs until none are left
+static void *programLoadWorker(void *argument) {
+    ProgramLoadJob *job = argument;
+
+    for (;;) {
+        int i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->num_programs) {
+            break;
+        }
+        if (job->wanted[i] && loadProgram(job, i) == -1) {
+            atomic_store(&job->failed, 1);
+        }
+    }
+    return NULL;
+}
+
+// Function to run one phase of a program load on the job's threads
+static int runProgramLoadPhase(ProgramLoadJob *job, int phase) {
+    job->phase = phase;
+    atomic_store(&job->next, 0);
+    if (runWorkers(programLoadWorker, job, job->num_programs, job->num_threads) == -1) {
+        return -1;
+    }
+    return atomic_load(&job->failed) ? -1 : 0;
+}
+
+// Function to pick the first program of each distinct file content as the one to parse
+// the hash only finds candidates, contents are compared before two programs share a parse
+static int findRepresentatives(ProgramLoadJob *job) {
+    int size = 16;
+    while (size < 2 * job->num_programs) {
+        size *= 2;
+    }
+    int *table = malloc(size * sizeof(int));
+    if (table == NULL) {
+        perror("Error allocating programs");
+        return -1;
+    }
+    for (int k = 0; k < size; k++) {
+        table[k] = -1;
+    }
+
+    for (int i = 0; i < job->num_programs; i++) {
+        if (!job->wanted[i]) {
+            continue;
+        }
+        const MappedFile *file = &job->files[i];
+        int k = (int)(job->hashes[i] & (uint64_t)(size - 1));
+        job->representative[i] = i;
+        while (table[k] != -1) {
+            int other = table[k];
+            if (job->hashes[other] == job->hashes[i] && job->files[other].size == file->size &&
+                memcmp(job->files[other].data, file->data, file->size) == 0) {
+                job->representative[i] = other;
+                break;
+            }
+            k = (k + 1) & (size - 1);
+        }
+        if (table[k] == -1) {
+            table[k] = i;
+        }
+    }
+    free(table);
+    return 0;
+}
+
+// Function to load the programs flagged in wanted (PX.txt at index X-1) into the pool
+// Files are mapped and parsed on a thread pool; files with the same content are parsed once
+// and their programs share one range of the pool
+static int loadProgramFiles(Workload *workload, const InstructionCatalog *catalog, const char *directory, const char *wanted, int numPrograms,
+                            int num_threads) {
+    InstructionPool *pool = &workload->pool;
+    ProgramLoadJob job;
+
+    // Program PX.txt lives at index X-1, its instruction ids in the shared pool
+    workload->programs = calloc(numPrograms > 0 ? numPrograms : 1, sizeof(Process));
+    workload->num_programs = numPrograms;
+    if (workload->programs == NULL) {
+        perror("Error allocating programs");
+        return -1;
+    }
+    Process *processes = workload->programs;
+
+    memset(&job, 0, sizeof(job));
+    job.catalog = catalog;
+    job.directory = directory;
+    job.wanted = wanted;
+    job.num_programs = numPrograms;
+    job.num_threads = num_threads;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.failed, 0);
+    int count = numPrograms > 0 ? numPrograms : 1;
+    job.files = calloc(count, sizeof(MappedFile));
+    job.hashes = calloc(count, sizeof(uint64_t));
+    job.representative = calloc(count, sizeof(int));
+    job.pools = calloc(count, sizeof(InstructionPool));
+    job.bursts = calloc(count, sizeof(int));
+
+    int result = 0;
+    if (job.files == NULL || job.hashes == NULL || job.representative == NULL || job.pools == NULL || job.bursts == NULL) {
+        perror("Error allocating programs");
+        result = -1;
+    }
+    if (result == 0) {
+        result = runProgramLoadPhase(&job, PROGRAM_MAP);
+    }
+    if (result == 0) {
+        result = findRepresentatives(&job);
+    }
+    if (result == 0) {
+        result = runProgramLoadPhase(&job, PROGRAM_PARSE);
+    }
+
+    // lay the distinct programs out back to back, in program order
+    int total = 0;
+    for (int i = 0; i < numPrograms && result == 0; i++) {
+        if (wanted[i] && job.representative[i] == i) {
+            total += job.pools[i].count;
+        }
+    }
+    if (result == 0) {
+        pool->ids = malloc((total > 0 ? total : 1) * sizeof(int));
+        pool->burst_prefix = malloc((total > 0 ? total : 1) * sizeof(int));
+        pool->capacity = total;
+        if (pool->ids == NULL || pool->burst_prefix == NULL) {
+            perror("Error allocating the instruction pool");
+            result = -1;
+        }
+    }
+    for (int i = 0; i < numPrograms && result == 0; i++) {
+        if (!wanted[i]) {
+            continue;
+        }
+        int r = job.representative[i];
+        processes[i].id = i;
+        if (r == i) {
+            const InstructionPool *program = &job.pools[i];
+            memcpy(pool->ids + pool->count, program->ids, program->count * sizeof(int));
+            memcpy(pool->burst_prefix + pool->count, program->burst_prefix, program->count * sizeof(int));
+            processes[i].instruction_offset = pool->count;
+            processes[i].instruction_count = program->count;
+            pool->count += program->count;
+        } else {
+            // representatives come first, so r is already placed
+            processes[i].instruction_offset = processes[r].instruction_offset;
+            processes[i].instruction_count = processes[r].instruction_count;
+        }
+        processes[i].burst_time = job.bursts[r];
+        processes[i].remaining_time = job.bursts[r];
+    }
+
+    for (int i = 0; i < numPrograms && job.files != NULL; i++) {
+        unmapFile(&job.files[i]);
+        if (job.pools != NULL) {
+            free(job.pools[i].ids);
+            free(job.pools[i].burst_prefix);
+        }
+    }
+    free(job.files);
+    free(job.hashes);
+    free(job.representative);
+    free(job.pools);
+    free(job.bursts);
+    return result;
+}
+
+// Function to load the programs referenced by the definitions into the pool
+static int loadPrograms(Workload *workload, const InstructionCatalog *catalog, const char *directory, int num_threads) {
+    ProcessTable *definitions = &workload->definitions;
+
+    int numPrograms = 0;
+    for (int i = 0; i < definitions->count; i++) {
+        if (definitions->items[i].id < 1 || definitions->items[i].id > MAX_ID) {
+            fprintf(stderr, "Invalid process id P%d in definition.txt\n", definitions->items[i].id);
+            return -1;
+        }
+        if (definitions->items[i].id > numPrograms) {
+            numPrograms = definitions->items[i].id;
+        }
+    }
+
+    char *wanted = calloc(numPrograms > 0 ? numPrograms : 1, 1);
+    if (wanted == NULL) {
+        perror("Error allocating programs");
+        return -1;
+    }
+    for (int i = 0; i < definitions->count; i++) {
+        wanted[definitions->items[i].id - 1] = 1;
+    }
+
+    int result = loadProgramFiles(workload, catalog, directory, wanted, numPrograms, num_threads);
+    free(wanted);
+    return result;
+}
+
+// Function to get the program number of a PX.txt file name, -1 for other names
+static int programNumber(const char *name) {
+    if (name[0] != 'P' || name[1] < '1' || name[1] > '9') {
+        return -1;
+    }
+
+    long number = 0;
+    const char *c = name + 1;
+    while (*c >= '0' && *c <= '9') {
+        number = number * 10 + (*c - '0');
+        if (number > MAX_ID) {
+            return -1;
+        }
+        c++;
+    }
+    return strcmp(c, ".txt") == 0 ? (int)number : -1;
+}
+
+// Function to load the instruction catalog of directory into catalog
+static int loadInstructionCatalog(const char *directory, InstructionCatalog *catalog) {
+    InstructionTable instructionLengths = {0};
+    char filename[4096];
+
+    // Instruction structure: id - burst time
+    int result = joinPath(filename, sizeof(filename), directory, "instructions.txt");
+    if (result != -1) {
+        result = readInstructionsFromFile(filename, &instructionLengths);
+    }
+    if (result != -1) {
+        result = buildInstructionCatalog(&instructionLengths, catalog);
+    }
+
+    free(instructionLengths.items);
+    return result == -1 ? -1 : 0;
+}
+
+// Function to load instructions.txt, definition.txt and the PX.txt files they reference from directory
+int loadTextWorkload(const char *directory, Workload *workload, int num_threads) {
+    InstructionCatalog catalog = {0};
+    char filename[4096];
+
+    memset(workload, 0, sizeof(*workload));
+
+    double start = monotonicMs();
+    int result = loadInstructionCatalog(directory, &catalog);
+    workload->load_ms[LOAD_INSTRUCTIONS] = monotonicMs() - start;
+    // Definitions first, so only the programs they reference are loaded
+    if (result != -1) {
+        result = joinPath(filename, sizeof(filename), directory, "definition.txt");
+    }
+    if (result != -1) {
+        start = monotonicMs();
+        result = readProcessesFromFile(filename, &workload->definitions);
+        workload->load_ms[LOAD_DEFINITIONS] = monotonicMs() - start;
+    }
+    if (result != -1) {
+        start = monotonicMs();
+        result = loadPrograms(workload, &catalog, directory, num_threads);
+        workload->load_ms[LOAD_PROGRAMS] = monotonicMs() - start;
+    }
+
+    free(catalog.burst_by_id);
+    if (result == -1) {
+        freeWorkload(workload);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to load instructions.txt and every PX.txt of directory, without definitions
+int loadProgramLibrary(const char *directory, Workload *workload, int num_threads) {
+    InstructionCatalog catalog = {0};
+    const char *path = directory != NULL && directory[0] != '\0' ? directory : ".";
+
+    memset(workload, 0, sizeof(*workload));
+
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        fprintf(stderr, "Error opening directory %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    // first pass finds the highest program number, the second flags every program present
+    int numPrograms = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int number = programNumber(entry->d_name);
+        if (number > numPrograms) {
+            numPrograms = number;
+        }
+    }
+
+    char *wanted = calloc(numPrograms > 0 ? numPrograms : 1, 1);
+    if (wanted == NULL) {
+        perror("Error allocating programs");
+        closedir(dir);
+        return -1;
+    }
+    rewinddir(dir);
+    while ((entry = readdir(dir)) != NULL) {
+        int number = programNumber(entry->d_name);
+        if (number > 0) {
+            wanted[number - 1] = 1;
+        }
+    }
+    closedir(dir);
+
+    double start = monotonicMs();
+    int result = loadInstructionCatalog(directory, &catalog);
+    workload->load_ms[LOAD_INSTRUCTIONS] = monotonicMs() - start;
+    if (result != -1) {
+        start = monotonicMs();
+        result = loadProgramFiles(workload, &catalog, directory, wanted, numPrograms, num_threads);
+        workload->load_ms[LOAD_PROGRAMS] = monotonicMs() - start;
+    }
+
+    free(wanted);
+    free(catalog.burst_by_id);
+    if (result == -1) {
+        freeWorkload(workload);
+        return -1;
+    }
+    return 0;
+}
+
+void freeWorkload(Workload *workload) {
+    if (workload->trace.mapped) {
+        // pool arrays point into the mapped trace
+        unmapFile(&workload->trace);
+    } else {
+        free(workload->pool.ids);
+        free(workload->pool.burst_prefix);
+    }
+    free(workload->programs);
+    free(workload->definitions.items);
+    memset(workload, 0, sizeof(*workload));
+}
+
+// Function to get the size of a trace section holding count 32-bit values, padded to 8 bytes
+static size_t traceSectionSize(uint32_t count) {
+    return ((size_t)count * sizeof(int32_t) + 7) & ~(size_t)7;
+}
+
+// Function to write one section of a trace, zero padded to 8 bytes
+static int writeTraceSection(FILE *file, const int32_t *values, uint32_t count) {
+    static const char padding[8] = {0};
+    size_t bytes = (size_t)count * sizeof(int32_t);
+
+    if (count > 0 && fwrite(values, sizeof(int32_t), count, file) != count) {
+        return -1;
+    }
+    if (fwrite(padding, 1, traceSectionSize(count) - bytes, file) != traceSectionSize(count) - bytes) {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to write a loaded workload as a binary trace
+// Layout: TraceHeader, then definitions as id/priority/arrival/type arrays,
+// programs as offset/count/burst arrays, and the pool as ids/burst_prefix arrays
+int writeTraceFile(const char *filename, const Workload *workload) {
+    uint32_t n = (uint32_t)workload->definitions.count;
+    uint32_t m = (uint32_t)workload->num_programs;
+    uint32_t p = (uint32_t)workload->pool.count;
+    int32_t *column = malloc(((n > m ? n : m) + 1) * sizeof(int32_t));
+
+    if (column == NULL) {
+        perror("Error allocating trace buffer");
+        return -1;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening file %s: %s\n", filename, strerror(errno));
+        free(column);
+        return -1;
+    }
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.byte_order = TRACE_BYTE_ORDER;
+    header.num_processes = n;
+    header.num_programs = m;
+    header.pool_count = p;
+
+    int result = fwrite(&header, sizeof(header), 1, file) == 1 ? 0 : -1;
+
+    const Process *definitions = workload->definitions.items;
+    for (int field = 0; field < 4 && result == 0; field++) {
+        for (uint32_t i = 0; i < n; i++) {
+            column[i] = field == 0 ? definitions[i].id : field == 1 ? definitions[i].priority
+                      : field == 2 ? definitions[i].arrival_time : definitions[i].type;
+        }
+        result = writeTraceSection(file, column, n);
+    }
+
+    const Process *programs = workload->programs;
+    for (int field = 0; field < 3 && result == 0; field++) {
+        for (uint32_t i = 0; i < m; i++) {
+            column[i] = field == 0 ? programs[i].instruction_offset : field == 1 ? programs[i].instruction_count
+                      : programs[i].burst_time;
+        }
+        result = writeTraceSection(file, column, m);
+    }
+
+    if (result == 0) {
+        result = writeTraceSection(file, workload->pool.ids, p);
+    }
+    if (result == 0) {
+        result = writeTraceSection(file, workload->pool.burst_prefix, p);
+    }
+
+    if (fclose(file) != 0 || result == -1) {
+        fprintf(stderr, "Error writing file %s\n", filename);
+        result = -1;
+    }
+    free(column);
+    return result;
+}
+
+// Function to load a binary trace with a single mmap; the pool is used in place
+int loadTraceFile(const char *filename, Workload *workload) {
+    double start = monotonicMs();
+
+    memset(workload, 0, sizeof(*workload));
+
+    if (mapFile(filename, &workload->trace) == -1) {
+        return -1;
+    }
+
+    const char *data = workload->trace.data;
+    size_t size = workload->trace.size;
+    TraceHeader header;
+
+    if (size < sizeof(header)) {
+        fprintf(stderr, "%s: not a scheduler trace\n", filename);
+        freeWorkload(workload);
+        return -1;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.byte_order != TRACE_BYTE_ORDER) {
+        fprintf(stderr, "%s: not a scheduler trace (or written on a machine of another byte order)\n", filename);
+        freeWorkload(workload);
+        return -1;
+    }
+    if (header.version != TRACE_VERSION) {
+        fprintf(stderr, "%s: unsupported trace version %u\n", filename, header.version);
+        freeWorkload(workload);
+        return -1;
+    }
+
+    uint32_t n = header.num_processes;
+    uint32_t m = header.num_programs;
+    uint32_t p = header.pool_count;
+    size_t expected = sizeof(header) + 4 * traceSectionSize(n) + 3 * traceSectionSize(m) + 2 * traceSectionSize(p);
+    if (n > INT32_MAX || m > INT32_MAX || p > INT32_MAX || size != expected) {
+        fprintf(stderr, "%s: truncated or corrupt trace\n", filename);
+        freeWorkload(workload);
+        return -1;
+    }
+
+    const int32_t *section[9];
+    const char *cursor = data + sizeof(header);
+    for (int s = 0; s < 9; s++) {
+        uint32_t count = s < 4 ? n : s < 7 ? m : p;
+        section[s] = (const int32_t *)cursor;
+        cursor += traceSectionSize(count);
+    }
+
+    workload->pool.ids = (int *)section[7];
+    workload->pool.burst_prefix = (int *)section[8];
+    workload->pool.count = (int)p;
+    workload->num_programs = (int)m;
+    workload->programs = calloc(m > 0 ? m : 1, sizeof(Process));
+    workload->definitions.items = malloc((n > 0 ? n : 1) * sizeof(Process));
+    workload->definitions.capacity = (int)n;
+
+    if (workload->programs == NULL || workload->definitions.items == NULL) {
+        perror("Error allocating trace workload");
+        freeWorkload(workload);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < m; i++) {
+        Process *program = &workload->programs[i];
+        program->id = (int)i;
+        program->instruction_offset = section[4][i];
+        program->instruction_count = section[5][i];
+        program->burst_time = section[6][i];
+        program->remaining_time = program->burst_time;
+        if (program->instruction_offset < 0 || program->instruction_count < 0 ||
+            (uint32_t)program->instruction_offset + (uint32_t)program->instruction_count > p) {
+            fprintf(stderr, "%s: program P%u lies outside the instruction pool\n", filename, i + 1);
+            freeWorkload(workload);
+            return -1;
+        }
+
+        // the engines trust the prefix sums, so they must be the running total of known instructions
+        const int *ids = &workload->pool.ids[program->instruction_offset];
+        const int *prefix = &workload->pool.burst_prefix[program->instruction_offset];
+        int total = 0;
+        for (int k = 0; k < program->instruction_count; k++) {
+            if ((ids[k] != -1 && (ids[k] < 1 || ids[k] > MAX_ID)) || prefix[k] < total) {
+                fprintf(stderr, "%s: program P%u has a corrupt instruction %d\n", filename, i + 1, k + 1);
+                freeWorkload(workload);
+                return -1;
+            }
+            total = prefix[k];
+        }
+        if (program->burst_time != total) {
+            fprintf(stderr, "%s: program P%u has burst time %d but its instructions add up to %d\n", filename, i + 1,
+                    program->burst_time, total);
+            freeWorkload(workload);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        Process *process = &workload->definitions.items[i];
+        memset(process, 0, sizeof(*process));
+        process->id = section[0][i];
+        process->priority = section[1][i];
+        process->arrival_time = section[2][i];
+        process->type = section[3][i];
+        if (process->id < 1 || (uint32_t)process->id > m || workload->programs[process->id - 1].instruction_count == 0 ||
+            process->type < 1 || process->type > 3) {
+            fprintf(stderr, "%s: invalid process entry %u\n", filename, i + 1);
+            freeWorkload(workload);
+            return -1;
+        }
+        workload->definitions.count++;
+    }
+    workload->load_ms[LOAD_TRACE] = monotonicMs() - start;
+    return 0;
+}
+
+// Function to step a splitmix64 generator; any seed, including 0, gives a full-period sequence
+static uint64_t nextRandom(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Function to draw a uniform double in [0, 1)
+static double randomUnit(uint64_t *state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Function to draw a uniform int in [low, high]
+static int randomRange(uint64_t *state, int low, int high) {
+    return low + (int)(randomUnit(state) * ((double)high - low + 1));
+}
+
+// Function to draw from an exponential distribution with the given mean
+static double randomExponential(uint64_t *state, double mean) {
+    return -mean * log(1.0 - randomUnit(state));
+}
+
+// Function to fill in the default generator settings
+// the defaults keep the CPU about 90% busy and 10^7 processes within int time
+void defaultGeneratorConfig(GeneratorConfig *config) {
+    config->seed = 1;
+    config->num_processes = 1000;
+    config->num_programs = 100;
+    config->arrival_pattern = ARRIVAL_POISSON;
+    config->mean_interarrival = 150.0;
+    config->burst_size = 8;
+    config->type_mix[0] = 1;   // platinum
+    config->type_mix[1] = 3;   // gold
+    config->type_mix[2] = 6;   // silver
+    config->max_priority = 5;
+    config->num_instructions = 20;
+    config->length_distribution = LENGTH_UNIFORM;
+    config->mean_instruction_length = 10;
+    config->mean_program_length = 8;
+}
+
+// Function to draw one instruction length, at least 1 ms
+static int drawInstructionLength(uint64_t *state, const GeneratorConfig *config) {
+    int mean = config->mean_instruction_length;
+    int length;
+
+    if (config->length_distribution == LENGTH_EXPONENTIAL) {
+        double value = randomExponential(state, mean);
+        length = value > 1000.0 * mean ? 1000 * mean : (int)value;
+    } else {
+        length = randomRange(state, 1, 2 * mean - 1);
+    }
+    return length > 0 ? length : 1;
+}
+
+// Function to check the settings of a generator, -1 with a message when one is out of range
+static int checkGeneratorConfig(const GeneratorConfig *config) {
+    if (config->num_processes < 0 || config->num_programs < 1 || config->num_programs > MAX_ID ||
+        config->num_instructions < 1 || config->num_instructions > MAX_ID ||
+        config->burst_size < 1 || config->max_priority < 1 || config->mean_instruction_length < 1 ||
+        config->mean_program_length < 1 || !(config->mean_interarrival >= 0.0)) {
+        fprintf(stderr, "Generator settings out of range\n");
+        return -1;
+    }
+    if (config->type_mix[0] < 0 || config->type_mix[1] < 0 || config->type_mix[2] < 0 ||
+        config->type_mix[0] + config->type_mix[1] + config->type_mix[2] <= 0) {
+        fprintf(stderr, "The type mix needs at least one positive weight\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to generate a synthetic workload; the same config and seed always give the same workload
+int generateWorkload(const GeneratorConfig *config, Workload *workload) {
+    uint64_t state = config->seed;
+    InstructionCatalog catalog = {0};
+    InstructionPool *pool = &workload->pool;
+
+    memset(workload, 0, sizeof(*workload));
+    if (checkGeneratorConfig(config) == -1) {
+        return -1;
+    }
+
+    // Instruction ids 1..num_instructions; exit keeps its usual 10 ms
+    catalog.max_id = config->num_instructions;
+    catalog.exit_burst = 10;
+    catalog.burst_by_id = malloc(((size_t)catalog.max_id + 1) * sizeof(int));
+    workload->programs = calloc(config->num_programs, sizeof(Process));
+    workload->num_programs = config->num_programs;
+    if (catalog.burst_by_id == NULL || workload->programs == NULL) {
+        perror("Error allocating the generated workload");
+        free(catalog.burst_by_id);
+        freeWorkload(workload);
+        return -1;
+    }
+    catalog.burst_by_id[0] = -1;
+    for (int id = 1; id <= catalog.max_id; id++) {
+        catalog.burst_by_id[id] = drawInstructionLength(&state, config);
+    }
+
+    // Programs: 1..2*mean-1 instructions each, then exit
+    int result = 0;
+    for (int i = 0; i < config->num_programs && result == 0; i++) {
+        Process *program = &workload->programs[i];
+        int length = randomRange(&state, 1, 2 * config->mean_program_length - 1);
+
+        result = reserveItems((void **)&pool->ids, &pool->capacity, pool->count + length + 1, sizeof(int));
+        if (result == -1) {
+            perror("Error allocating the generated workload");
+            break;
+        }
+        program->id = i;
+        program->instruction_offset = pool->count;
+        program->instruction_count = length + 1;
+        for (int k = 0; k < length; k++) {
+            pool->ids[pool->count++] = randomRange(&state, 1, config->num_instructions);
+        }
+        pool->ids[pool->count++] = -1;
+    }
+
+    if (result == 0) {
+        pool->burst_prefix = malloc((pool->count > 0 ? pool->count : 1) * sizeof(int));
+        if (pool->burst_prefix == NULL) {
+            perror("Error allocating burst prefix sums");
+            result = -1;
+        }
+    }
+    for (int i = 0; i < config->num_programs && result == 0; i++) {
+        Process *program = &workload->programs[i];
+        program->burst_time = computeBurstPrefix(pool, program->instruction_offset, program->instruction_count, &catalog, "generated program");
+        program->remaining_time = program->burst_time;
+        if (program->burst_time == -1) {
+            result = -1;
+        }
+    }
+    free(catalog.burst_by_id);
+
+    // Definitions, already in arrival order
+    ProcessTable *definitions = &workload->definitions;
+    if (result == 0 && config->num_processes > 0) {
+        result = reserveItems((void **)&definitions->items, &definitions->capacity, config->num_processes, sizeof(Process));
+        if (result == -1) {
+            perror("Error allocating the generated workload");
+        }
+    }
+
+    int mixTotal = config->type_mix[0] + config->type_mix[1] + config->type_mix[2];
+    double clock = 0.0;
+    for (int i = 0; i < config->num_processes && result == 0; i++) {
+        Process *process = &definitions->items[definitions->count++];
+        memset(process, 0, sizeof(*process));
+
+        // Poisson: exponential gaps; bursty: burst_size arrivals at once, bursts as far apart as burst_size gaps
+        if (config->arrival_pattern == ARRIVAL_BURSTY) {
+            if (i % config->burst_size == 0 && i > 0) {
+                clock += randomExponential(&state, config->mean_interarrival * config->burst_size);
+            }
+        } else if (i > 0) {
+            clock += randomExponential(&state, config->mean_interarrival);
+        }
+        // leave a quarter of the int range for the backlog after the last arrival
+        if (clock > INT_MAX / 4 * 3) {
+            fprintf(stderr, "Generated arrival times overflow; lower the process count or the interarrival time\n");
+            result = -1;
+            break;
+        }
+
+        int pick = randomRange(&state, 1, mixTotal);
+        process->type = pick <= config->type_mix[0] ? 1 : pick <= config->type_mix[0] + config->type_mix[1] ? 2 : 3;
+        process->id = randomRange(&state, 1, config->num_programs);
+        process->priority = randomRange(&state, 1, config->max_priority);
+        process->arrival_time = (int)clock;
+    }
+
+    if (result == -1) {
+        freeWorkload(workload);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to write a line based file, reporting the first error
+static int closeTextFile(FILE *file, const char *filename) {
+    int failed = ferror(file);
+    if (fclose(file) != 0 || failed) {
+        fprintf(stderr, "Error writing %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to write a workload as instructions.txt, definition.txt and PX.txt files in directory
+// Instruction lengths are recovered from the burst prefix sums of the pool
+int writeTextWorkload(const char *directory, const Workload *workload) {
+    const InstructionPool *pool = &workload->pool;
+    char filename[4096];
+    int maxId = 0;
+    int exitBurst = 10;
+
+    for (int k = 0; k < pool->count; k++) {
+        if (pool->ids[k] > maxId) {
+            maxId = pool->ids[k];
+        }
+    }
+    int *burstById = malloc(((size_t)maxId + 1) * sizeof(int));
+    if (burstById == NULL) {
+        perror("Error allocating instruction table");
+        return -1;
+    }
+    for (int id = 0; id <= maxId; id++) {
+        burstById[id] = -1;
+    }
+    for (int i = 0; i < workload->num_programs; i++) {
+        const Process *program = &workload->programs[i];
+        const int *prefix = &pool->burst_prefix[program->instruction_offset];
+        for (int k = 0; k < program->instruction_count; k++) {
+            int id = pool->ids[program->instruction_offset + k];
+            int burst = prefix[k] - (k > 0 ? prefix[k - 1] : 0);
+            if (id == -1) {
+                exitBurst = burst;
+            } else {
+                burstById[id] = burst;
+            }
+        }
+    }
+
+    FILE *file = NULL;
+    int result = joinPath(filename, sizeof(filename), directory, "instructions.txt");
+    if (result == 0 && (file = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", filename, strerror(errno));
+        result = -1;
+    }
+    if (result == 0) {
+        for (int id = 0; id <= maxId; id++) {
+            if (burstById[id] != -1) {
+                fprintf(file, "instr%d %d\n", id, burstById[id]);
+            }
+        }
+        fprintf(file, "exit %d\n", exitBurst);
+        result = closeTextFile(file, filename);
+    }
+    free(burstById);
+
+    for (int i = 0; i < workload->num_programs && result == 0; i++) {
+        const Process *program = &workload->programs[i];
+        char name[32];
+        if (program->instruction_count == 0) {
+            continue;
+        }
+        snprintf(name, sizeof(name), "P%d.txt", i + 1);
+        result = joinPath(filename, sizeof(filename), directory, name);
+        if (result == 0 && (file = fopen(filename, "w")) == NULL) {
+            fprintf(stderr, "Error opening %s: %s\n", filename, strerror(errno));
+            result = -1;
+        }
+        if (result == 0) {
+            for (int k = 0; k < program->instruction_count; k++) {
+                int id = pool->ids[program->instruction_offset + k];
+                if (id == -1) {
+                    fprintf(file, "exit\n");
+                } else {
+                    fprintf(file, "instr%d\n", id);
+                }
+            }
+            result = closeTextFile(file, filename);
+        }
+    }
+
+    if (result == 0) {
+        result = joinPath(filename, sizeof(filename), directory, "definition.txt");
+    }
+    if (result == 0 && (file = fopen(filename, "w")) == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", filename, strerror(errno));
+        result = -1;
+    }
+    if (result == 0) {
+        const ProcessTable *definitions = &workload->definitions;
+        for (int i = 0; i < definitions->count; i++) {
+            const Process *process = &definitions->items[i];
+            fprintf(file, "P%d %d %d %s\n", process->id, process->priority, process->arrival_time, typeName(process->type));
+        }
+        result = closeTextFile(file, filename);
+    }
+    return result;
+}
+
+// Function to read the monotonic clock in ms
+static double monotonicMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+#ifndef SCHEDULER_NO_MAIN
+// Function to print average waiting time and average turnaround time
+// whole numbers are printed without decimals
+static void printAverages(FILE *stream, const ScheduleAverages *averages) {
+    double avgTurnaround = averages->avg_turnaround;
+    double avgWaiting = averages->avg_waiting;
+
+    if (fmod(avgWaiting, 1.0) == 0.0) {
+        fprintf(stream, "%.0f\n", avgWaiting);
+    }
+    else {
+        fprintf(stream, "%.2f\n", avgWaiting);
+    }
+    if (fmod(avgTurnaround, 1.0) == 0.0) {
+        fprintf(stream, "%.0f\n", avgTurnaround);
+    }
+    else {
+        fprintf(stream, "%.2f\n", avgTurnaround);
+    }
+}
+
+// Function to print the per-CPU statistics of a multi-CPU run, waiting split by original type
+static void printCoreStats(FILE *stream, const ScheduleResults *results) {
+    fprintf(stream, "cpu\tbusy\tswitching\tmigrations\tplatinum_wait\tgold_wait\tsilver_wait\tplatinum_max\tgold_max\tsilver_max\n");
+    for (int c = 0; c < results->num_cores; c++) {
+        const CoreStats *core = &results->cores[c];
+        fprintf(stream, "%d\t%lld\t%lld\t%ld", c, core->busy_time, core->switch_time, core->migrations);
+        // mean wait per dispatch
+        for (int t = 0; t < 3; t++) {
+            fprintf(stream, "\t%.2f", core->tier_dispatches[t] > 0 ? (double)core->tier_waiting[t] / core->tier_dispatches[t] : 0.0);
+        }
+        for (int t = 0; t < 3; t++) {
+            fprintf(stream, "\t%d", core->tier_max_waiting[t]);
+        }
+        fputc('\n', stream);
+    }
+}
+
+// Function to parse a comma separated list of non-negative integers such as "60,80,100"
+static int parseIntList(const char *text, IntList *list) {
+    list->count = 0;
+
+    while (*text != '\0') {
+        char *end;
+        errno = 0;
+        long value = strtol(text, &end, 10);
+        if (end == text || errno != 0 || value < 0 || value > 1000000000L || (*end != ',' && *end != '\0')) {
+            fprintf(stderr, "Invalid value list: %s\n", text);
+            return -1;
+        }
+        if (reserveItems((void **)&list->values, &list->capacity, list->count + 1, sizeof(int)) == -1) {
+            return -1;
+        }
+        list->values[list->count++] = (int)value;
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    if (list->count == 0) {
+        fprintf(stderr, "Empty value list\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to parse the integer value of a command line option, at least minimum
+static int parseCountOption(const char *option, const char *text, int minimum, int *value) {
+    char *end;
+    errno = 0;
+    long number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || number < minimum || number > INT_MAX) {
+        fprintf(stderr, "Invalid value for %s: %s, expected an integer of at least %d\n", option, text, minimum);
+        return -1;
+    }
+    *value = (int)number;
+    return 0;
+}
+
+// Function to parse the non-negative real value of a command line option
+static int parseRatioOption(const char *option, const char *text, double *value) {
+    char *end;
+    errno = 0;
+    double number = strtod(text, &end);
+    if (end == text || *end != '\0' || errno != 0 || !(number >= 0.0)) {
+        fprintf(stderr, "Invalid value for %s: %s, expected a non-negative number\n", option, text);
+        return -1;
+    }
+    *value = number;
+    return 0;
+}
+
+// Function to parse a comma separated list of policy names such as "tiered,mlfq" into POLICY_ values
+static int parsePolicyList(const char *text, IntList *list) {
+    char name[32];
+
+    list->count = 0;
+    while (*text != '\0') {
+        size_t length = strcspn(text, ",");
+        int policy = -1;
+        if (length < sizeof(name)) {
+            memcpy(name, text, length);
+            name[length] = '\0';
+            policy = policyByName(name);
+        }
+        if (policy == -1) {
+            fprintf(stderr, "Unknown policy in %s, expected tiered, mlfq, cfs or edf\n", text);
+            return -1;
+        }
+        if (reserveItems((void **)&list->values, &list->capacity, list->count + 1, sizeof(int)) == -1) {
+            return -1;
+        }
+        list->values[list->count++] = policy;
+        text += text[length] == ',' ? length + 1 : length;
+    }
+
+    if (list->count == 0) {
+        fprintf(stderr, "Empty policy list\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to expand the option lists into the cartesian product of configurations
+// an empty list keeps the default value, empty threshold lists derive 3 and 5 quantums
+static int buildPolicyGrid(const IntList lists[SWEEP_PARAMETERS], PolicyConfig **grid) {
+    PolicyConfig defaults;
+    defaultPolicyConfig(&defaults);
+
+    int total = 1;
+    for (int p = 0; p < SWEEP_PARAMETERS; p++) {
+        if (lists[p].count > 0) {
+            if (total > 1000000 / lists[p].count) {
+                fprintf(stderr, "Sweep grid too large\n");
+                return -1;
+            }
+            total *= lists[p].count;
+        }
+    }
+
+    *grid = malloc(total * sizeof(PolicyConfig));
+    if (*grid == NULL) {
+        perror("Error allocating sweep grid");
+        return -1;
+    }
+
+    for (int c = 0; c < total; c++) {
+        int value[SWEEP_PARAMETERS];
+        int rest = c;
+
+        // the last parameter varies fastest
+        for (int p = SWEEP_PARAMETERS - 1; p >= 0; p--) {
+            if (lists[p].count > 0) {
+                value[p] = lists[p].values[rest % lists[p].count];
+                rest /= lists[p].count;
+            } else {
+                value[p] = -1;
+            }
+        }
+
+        PolicyConfig *config = &(*grid)[c];
+        *config = defaults;
+        config->silver_quantum = value[0] != -1 ? value[0] : defaults.silver_quantum;
+        config->gold_quantum = value[1] != -1 ? value[1] : defaults.gold_quantum;
+        config->context_switch = value[2] != -1 ? value[2] : defaults.context_switch;
+        config->silver_to_gold_threshold = value[3] != -1 ? value[3] : 3 * config->silver_quantum;
+        config->gold_to_platinum_threshold = value[4] != -1 ? value[4] : 5 * config->gold_quantum;
+        config->num_cpus = value[5] != -1 ? value[5] : defaults.num_cpus;
+        config->migration_cost = value[6] != -1 ? value[6] : defaults.migration_cost;
+        config->policy = value[SWEEP_POLICY] != -1 ? value[SWEEP_POLICY] : defaults.policy;
+
+        if (config->silver_quantum == 0 || config->gold_quantum == 0) {
+            fprintf(stderr, "Quantums must be positive\n");
+            free(*grid);
+            return -1;
+        }
+        if (config->num_cpus < 1 || config->num_cpus > MAX_CPUS) {
+            fprintf(stderr, "CPU counts must be between 1 and %d\n", MAX_CPUS);
+            free(*grid);
+            return -1;
+        }
+    }
+    return total;
+}
+
+// Function to print one row per definition file of a batch, in the order given
+static void printBatchTable(FILE *stream, const char *const paths[], const BatchResult results[], int num_paths) {
+    fprintf(stream, "scenario\tprocesses\tavg_waiting\tavg_turnaround\tavg_response\tthroughput\tdeadline_miss_rate\n");
+    for (int b = 0; b < num_paths; b++) {
+        const BatchResult *result = &results[b];
+        if (result->failed) {
+            fprintf(stream, "%s\tfailed\n", paths[b]);
+            continue;
+        }
+        fprintf(stream, "%s\t%d\t%.2f\t%.2f\t%.2f\t%.3f\t%.4f\n", paths[b], result->num_processes, result->averages.avg_waiting,
+                result->averages.avg_turnaround, result->averages.avg_response, result->averages.throughput,
+                result->averages.deadline_miss_rate);
+    }
+}
+
+// Function to print one row per configuration of a sweep
+static void printSweepTable(FILE *stream, const PolicyConfig configs[], const ScheduleAverages results[], int num_configs) {
+    fprintf(stream, "silver_quantum\tgold_quantum\tcontext_switch\tsilver_to_gold\tgold_to_platinum\tcpus\tmigration_cost\tpolicy"
+            "\tavg_waiting\tavg_turnaround\tavg_response\tthroughput\tdeadline_miss_rate\n");
+    for (int c = 0; c < num_configs; c++) {
+        fprintf(stream, "%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s\t%.2f\t%.2f\t%.2f\t%.3f\t%.4f\n", configs[c].silver_quantum, configs[c].gold_quantum,
+               configs[c].context_switch, configs[c].silver_to_gold_threshold, configs[c].gold_to_platinum_threshold, configs[c].num_cpus,
+               configs[c].migration_cost, policyName(configs[c].policy), results[c].avg_waiting, results[c].avg_turnaround,
+               results[c].avg_response, results[c].throughput, results[c].deadline_miss_rate);
+    }
+}
+
+// Function to print the summary of a replication run, one row per metric
+static void printReplicationSummary(FILE *stream, const ReplicationSummary *summary) {
+    static const char *const names[4] = {"avg", "p50", "p95", "p99"};
+
+    fprintf(stream, "replications\t%d\n", summary->replications);
+    fprintf(stream, "metric\tmean\tci95_low\tci95_high\tstddev\tmin\tmax\n");
+    for (int m = 0; m < 8; m++) {
+        const MetricSummary *metric = m < 4 ? &summary->waiting[m] : &summary->turnaround[m - 4];
+        fprintf(stream, "%s_%s\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\n", m < 4 ? "waiting" : "turnaround", names[m % 4],
+                metric->mean, metric->ci_low, metric->ci_high, metric->stddev, metric->min, metric->max);
+    }
+}
+
+// Function to parse a generator option at argv[*i]; returns 1 when it was one, 0 when not, -1 on bad values
+static int parseGeneratorOption(int argc, char *argv[], int *i, GeneratorConfig *config) {
+    static const char *const options[] = {
+        "--seed", "--processes", "--programs", "--arrival", "--interarrival", "--burst", "--mix",
+        "--priorities", "--instructions", "--instruction-length", "--instruction-mean", "--program-length"
+    };
+    int option = -1;
+
+    for (size_t p = 0; p < sizeof(options) / sizeof(options[0]); p++) {
+        if (strcmp(argv[*i], options[p]) == 0) {
+            option = (int)p;
+        }
+    }
+    if (option == -1 || *i + 1 >= argc) {
+        return 0;
+    }
+
+    const char *value = argv[++*i];
+    char *end;
+    char extra;
+    long number = strtol(value, &end, 10);
+    int valid = *end == '\0' && end != value && number >= 0 && number <= INT_MAX;
+
+    switch (option) {
+    case 0:
+        // strtoull would wrap "-5" around to a huge seed, so the value must start with a digit
+        errno = 0;
+        config->seed = strtoull(value, &end, 10);
+        valid = value[0] >= '0' && value[0] <= '9' && *end == '\0' && errno == 0;
+        break;
+    case 1:
+        config->num_processes = (int)number;
+        break;
+    case 2:
+        config->num_programs = (int)number;
+        break;
+    case 3:
+        valid = strcmp(value, "poisson") == 0 || strcmp(value, "bursty") == 0;
+        config->arrival_pattern = strcmp(value, "bursty") == 0 ? ARRIVAL_BURSTY : ARRIVAL_POISSON;
+        break;
+    case 4:
+        config->mean_interarrival = strtod(value, &end);
+        valid = *end == '\0' && end != value;
+        break;
+    case 5:
+        config->burst_size = (int)number;
+        break;
+    case 6:
+        valid = sscanf(value, "%d,%d,%d%c", &config->type_mix[0], &config->type_mix[1], &config->type_mix[2], &extra) == 3;
+        break;
+    case 7:
+        config->max_priority = (int)number;
+        break;
+    case 8:
+        config->num_instructions = (int)number;
+        break;
+    case 9:
+        valid = strcmp(value, "uniform") == 0 || strcmp(value, "exponential") == 0;
+        config->length_distribution = strcmp(value, "exponential") == 0 ? LENGTH_EXPONENTIAL : LENGTH_UNIFORM;
+        break;
+    case 10:
+        config->mean_instruction_length = (int)number;
+        break;
+    default:
+        config->mean_program_length = (int)number;
+        break;
+    }
+
+    if (!valid) {
+        fprintf(stderr, "Invalid value for %s: %s\n", options[option], value);
+        return -1;
+    }
+    return 1;
+}
+
+// Function to benchmark every workload size: generate, load (through a binary trace), schedule, report
+// peak RSS is the process high-water mark so far, sizes run in the order given
+static int runBenchmark(FILE *stream, const GeneratorConfig *generator, const PolicyConfig *policy, const IntList *sizes) {
+    char tracePath[4096];
+    const char *tmpdir = getenv("TMPDIR");
+    int length = snprintf(tracePath, sizeof(tracePath), "%s/schedbench-XXXXXX", tmpdir != NULL ? tmpdir : "/tmp");
+    if (length < 0 || (size_t)length >= sizeof(tracePath)) {
+        fprintf(stderr, "TMPDIR path too long\n");
+        return -1;
+    }
+    int fd = mkstemp(tracePath);
+    if (fd == -1) {
+        perror("Error creating the benchmark trace");
+        return -1;
+    }
+    close(fd);
+
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        perror("Error opening /dev/null");
+        unlink(tracePath);
+        return -1;
+    }
+
+    fprintf(stream, "%10s %12s %10s %12s %10s %12s %14s %12s %14s %14s\n", "processes", "generate_ms", "load_ms",
+            "schedule_ms", "report_ms", "events", "events_per_s", "peak_rss_kb", "avg_waiting", "avg_turnaround");
+
+    int status = 0;
+    for (int s = 0; s < sizes->count && status == 0; s++) {
+        GeneratorConfig config = *generator;
+        Workload generated;
+        Workload workload;
+        ScheduleResults results = {0};
+        SchedulerContext *context = NULL;
+        config.num_processes = sizes->values[s];
+        results.per_process = 1;
+
+        double start = monotonicMs();
+        if (generateWorkload(&config, &generated) == -1) {
+            status = -1;
+            break;
+        }
+        double generateMs = monotonicMs() - start;
+
+        int written = writeTraceFile(tracePath, &generated);
+        freeWorkload(&generated);
+        if (written == -1) {
+            status = -1;
+            break;
+        }
+
+        start = monotonicMs();
+        if (loadTraceFile(tracePath, &workload) == -1) {
+            status = -1;
+            break;
+        }
+        double loadMs = monotonicMs() - start;
+
+        start = monotonicMs();
+        context = createSchedulerContext();
+        if (context == NULL || scheduleWorkload(context, &workload, policy, &results) == -1) {
+            status = -1;
+        }
+        double scheduleMs = monotonicMs() - start;
+
+        // Report: per-process results in definition order, as a results file would hold them
+        start = monotonicMs();
+        for (int i = 0; i < results.num_processes && status == 0; i++) {
+            fprintf(sink, "P%d %d %d\n", workload.definitions.items[i].id, results.turnaround_times[i], results.waiting_times[i]);
+        }
+        printAverages(sink, &results.averages);
+        double reportMs = monotonicMs() - start;
+
+        if (status == 0) {
+            // arrivals, context switches, CPU slices and completions
+            long events = 2L * results.num_processes + results.total_context_switches + results.num_dispatches;
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            fprintf(stream, "%10d %12.1f %10.1f %12.1f %10.1f %12ld %14.0f %12ld %14.2f %14.2f\n", config.num_processes,
+                    generateMs, loadMs, scheduleMs, reportMs, events, scheduleMs > 0.0 ? events / (scheduleMs / 1000.0) : 0.0,
+                    usage.ru_maxrss, results.averages.avg_waiting, results.averages.avg_turnaround);
+            fflush(stream);
+        }
+
+        freeScheduleResults(&results);
+        destroySchedulerContext(context);
+        freeWorkload(&workload);
+    }
+
+    fclose(sink);
+    unlink(tracePath);
+    return status;
+}
+
+// Function to get the length of instruction k of a process from the prefix sums of the pool
+static int instructionLength(const InstructionPool *pool, const Process *process, int k) {
+    const int *prefix = &pool->burst_prefix[process->instruction_offset];
+    return prefix[k] - (k > 0 ? prefix[k - 1] : 0);
+}
+
+// Function to check whether ready process a (queued at sequence sa) goes before b under the tiered rules:
+// platinum first, then the highest priority of its tier group, then the earliest queued
+static int referenceOutranks(const Process *a, long sa, const Process *b, long sb) {
+    if ((a->type == 1) != (b->type == 1)) {
+        return a->type == 1;
+    }
+    if (a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+    return sa < sb;
+}
+
+/*
+ * Reference engine of the fuzz harness: the tiered single-CPU semantics written as plainly as
+ * possible, to check the optimized engine against. Processes run one instruction at a time; at
+ * every instruction boundary the slice ends on completion, when the next instruction no longer
+ * fits the quantum, or when a process that arrived by then preempts the running one. The ready
+ * queue is scanned linearly. Instruction lengths must be at least 1 ms.
+ * Fills turnaround and waiting per definition, returns the number of context switches or -1.
+ */
+static long referenceSchedule(const Workload *workload, const PolicyConfig *config, int turnaround[], int waiting[]) {
+    const InstructionPool *pool = &workload->pool;
+    int n = workload->definitions.count;
+    Process *processes = malloc((n > 0 ? n : 1) * sizeof(Process));
+    int *order = malloc((n > 0 ? n : 1) * sizeof(int));
+    long *sequence = malloc((n > 0 ? n : 1) * sizeof(long));
+    char *ready = calloc(n > 0 ? n : 1, 1);
+
+    if (processes == NULL || order == NULL || sequence == NULL || ready == NULL) {
+        perror("Error allocating the reference engine");
+        free(processes);
+        free(order);
+        free(sequence);
+        free(ready);
+        return -1;
+    }
+
+    // arrival order: arrival time, then id, then definition order (insertion sort, stable)
+    for (int i = 0; i < n; i++) {
+        processes[i] = workload->definitions.items[i];
+        startProcess(&processes[i], &workload->programs[processes[i].id - 1]);
+        int j = i;
+        while (j > 0 && (processes[order[j - 1]].arrival_time > processes[i].arrival_time ||
+                         (processes[order[j - 1]].arrival_time == processes[i].arrival_time &&
+                          processes[order[j - 1]].id > processes[i].id))) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    long contextSwitches = 0;
+    long nextSequence = 0;
+    int next = 0;
+    int done = 0;
+    int lastRun = -1;
+    int time = 0;
+    while (done < n) {
+        while (next < n && processes[order[next]].arrival_time <= time) {
+            ready[order[next]] = 1;
+            sequence[order[next]] = nextSequence++;
+            next++;
+        }
+
+        int selected = -1;
+        for (int i = 0; i < n; i++) {
+            if (ready[i] && (selected == -1 || referenceOutranks(&processes[i], sequence[i], &processes[selected], sequence[selected]))) {
+                selected = i;
+            }
+        }
+        if (selected == -1) {
+            time = processes[order[next]].arrival_time;
+            continue;
+        }
+        ready[selected] = 0;
+
+        Process *running = &processes[selected];
+        if (selected != lastRun) {
+            time += config->context_switch;
+            contextSwitches++;
+        }
+        lastRun = selected;
+
+        long long quantum = running->type == 1 ? LLONG_MAX : running->type == 3 ? config->silver_quantum : config->gold_quantum;
+        int start = time;
+        int expired = 0;
+        for (;;) {
+            int length = instructionLength(pool, running, running->instruction_index);
+            time += length;
+            running->remaining_time -= length;
+            running->instruction_index++;
+            if (running->instruction_index == running->instruction_count) {
+                break;
+            }
+            if ((long long)time - start + instructionLength(pool, running, running->instruction_index) > quantum) {
+                expired = 1;
+                break;
+            }
+            // platinum preempts gold and silver, otherwise only a strictly higher priority preempts
+            int preempted = 0;
+            for (int j = next; j < n && processes[order[j]].arrival_time <= time; j++) {
+                const Process *arrival = &processes[order[j]];
+                if (arrival->type == 1 ? running->type != 1 : running->type != 1 && arrival->priority > running->priority) {
+                    preempted = 1;
+                }
+            }
+            if (preempted) {
+                break;
+            }
+        }
+
+        if (running->instruction_index == running->instruction_count) {
+            turnaround[selected] = time - running->arrival_time;
+            waiting[selected] = turnaround[selected] - running->burst_time;
+            done++;
+            lastRun = -1;
+            continue;
+        }
+
+        int executed = running->burst_time - running->remaining_time;
+        if (running->type == 3 && executed >= config->silver_to_gold_threshold) {
+            running->type = 2;
+        }
+        if (running->type == 2 && executed >= config->gold_to_platinum_threshold) {
+            running->type = 1;
+        }
+        // arrivals up to now queue ahead; a preempted process keeps its place, an expired one goes last
+        while (next < n && processes[order[next]].arrival_time <= time) {
+            ready[order[next]] = 1;
+            sequence[order[next]] = nextSequence++;
+            next++;
+        }
+        if (expired) {
+            sequence[selected] = nextSequence++;
+        }
+        ready[selected] = 1;
+    }
+
+    free(processes);
+    free(order);
+    free(sequence);
+    free(ready);
+    return contextSwitches;
+}
+
+// Function to schedule cases random small workloads with both the engine and the reference engine
+// Each case draws its generator and policy settings from seed; mismatches are reported with
+// the options that regenerate the workload. Returns the number of mismatching cases, -1 on errors
+static int runFuzz(FILE *stream, unsigned long long seed, int cases) {
+    SchedulerContext *context = createSchedulerContext();
+    ScheduleResults results = {0};
+    int *turnaround = NULL;
+    int *waiting = NULL;
+    int turnaroundCapacity = 0;
+    int waitingCapacity = 0;
+    uint64_t state = seed;
+    int mismatches = 0;
+    int status = 0;
+
+    if (context == NULL) {
+        perror("Error allocating the fuzz harness");
+        return -1;
+    }
+    results.per_process = 1;
+
+    for (int c = 0; c < cases && status == 0; c++) {
+        GeneratorConfig generator;
+        PolicyConfig policy;
+        Workload workload;
+
+        defaultGeneratorConfig(&generator);
+        generator.seed = nextRandom(&state);
+        generator.num_processes = randomRange(&state, 1, 40);
+        generator.num_programs = randomRange(&state, 1, 8);
+        generator.arrival_pattern = randomRange(&state, 0, 1) ? ARRIVAL_BURSTY : ARRIVAL_POISSON;
+        generator.mean_interarrival = randomRange(&state, 0, 200);
+        generator.burst_size = randomRange(&state, 1, 6);
+        generator.type_mix[0] = randomRange(&state, 0, 3);
+        generator.type_mix[1] = randomRange(&state, 0, 3);
+        generator.type_mix[2] = randomRange(&state, 1, 3);
+        generator.max_priority = randomRange(&state, 1, 4);
+        generator.num_instructions = randomRange(&state, 1, 6);
+        generator.length_distribution = randomRange(&state, 0, 1) ? LENGTH_EXPONENTIAL : LENGTH_UNIFORM;
+        generator.mean_instruction_length = randomRange(&state, 1, 40);
+        generator.mean_program_length = randomRange(&state, 1, 10);
+
+        defaultPolicyConfig(&policy);
+        policy.silver_quantum = randomRange(&state, 1, 150);
+        policy.gold_quantum = randomRange(&state, 1, 200);
+        policy.context_switch = randomRange(&state, 0, 20);
+        policy.silver_to_gold_threshold = randomRange(&state, 0, 400);
+        policy.gold_to_platinum_threshold = randomRange(&state, 0, 800);
+
+        if (generateWorkload(&generator, &workload) == -1) {
+            status = -1;
+            break;
+        }
+        int n = workload.definitions.count;
+        if (reserveItems((void **)&turnaround, &turnaroundCapacity, n, sizeof(int)) == -1 ||
+            reserveItems((void **)&waiting, &waitingCapacity, n, sizeof(int)) == -1) {
+            perror("Error allocating the fuzz harness");
+            status = -1;
+        }
+
+        long contextSwitches = status == 0 ? referenceSchedule(&workload, &policy, turnaround, waiting) : -1;
+        if (contextSwitches == -1 || scheduleWorkload(context, &workload, &policy, &results) == -1) {
+            status = -1;
+        } else {
+            int differs = contextSwitches != results.total_context_switches;
+            int first = -1;
+            for (int i = 0; i < n && first == -1; i++) {
+                if (turnaround[i] != results.turnaround_times[i] || waiting[i] != results.waiting_times[i]) {
+                    first = i;
+                }
+            }
+            if (differs || first != -1) {
+                mismatches++;
+                fprintf(stream, "case %d: engine and reference differ", c);
+                if (first != -1) {
+                    fprintf(stream, " at definition %d (P%d): turnaround %d vs %d, waiting %d vs %d", first,
+                            workload.definitions.items[first].id, results.turnaround_times[first], turnaround[first],
+                            results.waiting_times[first], waiting[first]);
+                } else {
+                    fprintf(stream, " in context switches: %ld vs %ld", results.total_context_switches, contextSwitches);
+                }
+                fprintf(stream, "\n  --seed %llu --processes %d --programs %d --arrival %s --interarrival %.0f --burst %d --mix %d,%d,%d"
+                        " --priorities %d --instructions %d --instruction-length %s --instruction-mean %d --program-length %d\n"
+                        "  --silver-quantum %d --gold-quantum %d --context-switch %d --silver-to-gold %d --gold-to-platinum %d\n",
+                        generator.seed, generator.num_processes, generator.num_programs,
+                        generator.arrival_pattern == ARRIVAL_BURSTY ? "bursty" : "poisson", generator.mean_interarrival,
+                        generator.burst_size, generator.type_mix[0], generator.type_mix[1], generator.type_mix[2],
+                        generator.max_priority, generator.num_instructions,
+                        generator.length_distribution == LENGTH_EXPONENTIAL ? "exponential" : "uniform",
+                        generator.mean_instruction_length, generator.mean_program_length, policy.silver_quantum,
+                        policy.gold_quantum, policy.context_switch, policy.silver_to_gold_threshold, policy.gold_to_platinum_threshold);
+            }
+        }
+        freeWorkload(&workload);
+    }
+
+    if (status == 0) {
+        fprintf(stream, "fuzz: %d cases, %d mismatches\n", cases, mismatches);
+    }
+    free(turnaround);
+    free(waiting);
+    freeScheduleResults(&results);
+    destroySchedulerContext(context);
+    return status == -1 ? -1 : mismatches;
+}
+
+// Function to write the golden output of a recorded run: per-process metrics, then every event
+static int writeGolden(FILE *stream, const EventRecorder *recorder) {
+    if (writeProcessMetricsCsv(stream, recorder) == -1) {
+        return -1;
+    }
+    return writeEventsCsv(stream, recorder);
+}
+
+// Function to compare a recorded run with the golden output in path
+// Returns 0 when they match, 1 with the first differing line reported, -1 on errors
+static int checkGolden(const char *path, const EventRecorder *recorder) {
+    FILE *golden = fopen(path, "r");
+    if (golden == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    FILE *actual = tmpfile();
+    if (actual == NULL || writeGolden(actual, recorder) == -1) {
+        perror("Error writing the run for comparison");
+        fclose(golden);
+        if (actual != NULL) {
+            fclose(actual);
+        }
+        return -1;
+    }
+    rewind(actual);
+
+    char *expectedLine = NULL;
+    char *actualLine = NULL;
+    size_t expectedCapacity = 0;
+    size_t actualCapacity = 0;
+    int result = 0;
+    for (long line = 1; result == 0; line++) {
+        ssize_t expectedLength = getline(&expectedLine, &expectedCapacity, golden);
+        ssize_t actualLength = getline(&actualLine, &actualCapacity, actual);
+        if (expectedLength == -1 && actualLength == -1) {
+            break;
+        }
+        if (expectedLength != actualLength || memcmp(expectedLine, actualLine, expectedLength) != 0) {
+            fprintf(stderr, "%s:%ld: golden output differs\n  expected: %s  actual:   %s", path, line,
+                    expectedLength == -1 ? "end of file\n" : expectedLine, actualLength == -1 ? "end of run\n" : actualLine);
+            result = 1;
+        }
+    }
+
+    free(expectedLine);
+    free(actualLine);
+    fclose(golden);
+    fclose(actual);
+    return result;
+}
+
+// Function to print the command line options
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--dir DIR | --trace FILE] [--convert FILE] [--stream FILE | --batch PATH] [--output FILE] [policy options] [--sweep] [--threads N]\n", program);
+    fprintf(stderr, "       [--events FILE] [--metrics FILE] [--chrome-trace FILE] [--stats] [--profile] [--checkpoint-every MS] [--resume FILE]\n");
+    fprintf(stderr, "       [--golden-record FILE | --golden-check FILE]\n");
+    fprintf(stderr, "       %s --generate DIR | --bench [--bench-sizes LIST] | --fuzz N [generator options] [policy options]\n", program);
+    fprintf(stderr, "  --dir DIR       read instructions.txt, definition.txt and PX.txt from DIR (default: current directory)\n");
+    fprintf(stderr, "  --trace FILE    load the workload from a binary trace instead of the text files\n");
+    fprintf(stderr, "  --convert FILE  write the loaded workload as a binary trace to FILE and exit\n");
+    fprintf(stderr, "  --stream FILE   schedule definitions read from FILE ('-' for standard input) as they arrive,\n");
+    fprintf(stderr, "                  against every PX.txt in DIR; arrival times must not decrease\n");
+    fprintf(stderr, "  --batch PATH    schedule many definition files against every PX.txt in DIR, loaded once, on --threads\n");
+    fprintf(stderr, "                  threads and write one row per file; PATH is a directory of definition .txt files\n");
+    fprintf(stderr, "                  or a manifest listing one file per line\n");
+    fprintf(stderr, "  --output FILE   write the results to FILE instead of standard output\n");
+    fprintf(stderr, "  --events FILE   write every scheduling event of the run to FILE as CSV\n");
+    fprintf(stderr, "  --metrics FILE  write turnaround, waiting and response time of every process to FILE as CSV\n");
+    fprintf(stderr, "  --chrome-trace FILE  write the run as Chrome trace-event JSON (chrome://tracing, Perfetto)\n");
+    fprintf(stderr, "  --stats         also print count, mean, stddev, min, max, p50, p95 and p99 of waiting, turnaround\n");
+    fprintf(stderr, "                  and response time, overall and per original and final type\n");
+    fprintf(stderr, "  --golden-record FILE  write the per-process metrics and every event of the run to FILE\n");
+    fprintf(stderr, "  --golden-check FILE   compare the run with a recorded golden FILE, exit status 1 at the first difference\n");
+    fprintf(stderr, "  --profile       also print wall-clock ms per phase (loading, schedule, report) and the counters of the\n");
+    fprintf(stderr, "                  scheduling loop (removed when built with -DSCHEDULER_NO_PROFILE)\n");
+    fprintf(stderr, "  --checkpoint-every MS  snapshot the run every MS simulated ms to PREFIX-<time>.ckpt\n");
+    fprintf(stderr, "  --checkpoint-prefix PREFIX  path prefix of the snapshots (default: checkpoint)\n");
+    fprintf(stderr, "  --resume FILE   continue the run of a snapshot of the same input, CPU count and balancing;\n");
+    fprintf(stderr, "                  other policy options may differ to fork it\n");
+    fprintf(stderr, "policy options take a comma separated list of ms values, e.g. --silver-quantum 60,80,100\n");
+    fprintf(stderr, "  --silver-quantum, --gold-quantum, --context-switch, --silver-to-gold, --gold-to-platinum,\n");
+    fprintf(stderr, "  --cpus (simulated CPUs, default 1), --migration-cost (default 5)\n");
+    fprintf(stderr, "  --balance global|steal|affinity  load balancing of multi-CPU runs (default: global)\n");
+    fprintf(stderr, "  --policy tiered|mlfq|cfs|edf  scheduling policy, a list compares several on the same input (default: tiered)\n");
+    fprintf(stderr, "  --deadlines P,G,S  completion deadlines after arrival per type for edf and the miss rate (default 1000,4000,16000)\n");
+    fprintf(stderr, "  --sweep         run every combination of the listed values and print a table\n");
+    fprintf(stderr, "                  (implied when a list has more than one value)\n");
+    fprintf(stderr, "  --threads N     threads for loading PX.txt files, sweeps, batches and replications (default: one per online CPU)\n");
+    fprintf(stderr, "  --replications K  schedule K randomized copies of the workload and report means with 95%% confidence\n");
+    fprintf(stderr, "                  intervals of the average, p50, p95 and p99 waiting and turnaround times\n");
+    fprintf(stderr, "  --jitter MS     move each arrival uniformly within +-MS per replication (default 10)\n");
+    fprintf(stderr, "  --length-variation F  scale each instruction length uniformly within 1+-F per replication (default 0.2)\n");
+    fprintf(stderr, "                  --seed N selects the random streams of the replications\n");
+    fprintf(stderr, "  --generate DIR  write a synthetic workload as text files into the existing directory DIR\n");
+    fprintf(stderr, "  --fuzz N        schedule N random small workloads (seeded by --seed) with the engine and a plain\n");
+    fprintf(stderr, "                  reference engine of the tiered single-CPU rules, exit status 1 on any mismatch\n");
+    fprintf(stderr, "  --bench         time generation, loading, scheduling and reporting of synthetic workloads\n");
+    fprintf(stderr, "  --bench-sizes LIST  process counts to benchmark (default: 10,100,...,10000000)\n");
+    fprintf(stderr, "generator options (defaults in parentheses):\n");
+    fprintf(stderr, "  --seed N (1)  --processes N (1000)  --programs N (100)  --priorities N (5)\n");
+    fprintf(stderr, "  --arrival poisson|bursty (poisson)  --interarrival MS (150)  --burst N (8)\n");
+    fprintf(stderr, "  --mix PLATINUM,GOLD,SILVER weights (1,3,6)  --instructions N distinct ids (20)\n");
+    fprintf(stderr, "  --instruction-length uniform|exponential (uniform)  --instruction-mean MS (10)\n");
+    fprintf(stderr, "  --program-length N mean instructions per program (8)\n");
+}
+
+// Function to append directory/name to a growable list of paths
+static int addBatchPath(char ***paths, int *count, int *capacity, const char *directory, const char *name) {
+    char path[4096];
+
+    if (joinPath(path, sizeof(path), name[0] == '/' ? NULL : directory, name) == -1) {
+        return -1;
+    }
+    if (reserveItems((void **)paths, capacity, *count + 1, sizeof(char *)) == -1 || ((*paths)[*count] = strdup(path)) == NULL) {
+        perror("Error allocating the batch");
+        return -1;
+    }
+    (*count)++;
     return 0;
 }
+
+// Function to order batch paths by name
+static int comparePaths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Function to list the definition files of a batch
+// A directory contributes every .txt file other than instructions.txt and PX.txt, in name order;
+// any other file is a manifest of one path per line (relative to the manifest, # starts a comment)
+static int listBatchFiles(const char *path, char ***paths, int *count) {
+    int capacity = 0;
+    struct stat info;
+
+    *paths = NULL;
+    *count = 0;
+    if (stat(path, &info) == -1) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int result = 0;
+    if (S_ISDIR(info.st_mode)) {
+        DIR *dir = opendir(path);
+        if (dir == NULL) {
+            fprintf(stderr, "Error opening directory %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        struct dirent *entry;
+        while (result == 0 && (entry = readdir(dir)) != NULL) {
+            size_t length = strlen(entry->d_name);
+            if (length > 4 && strcmp(entry->d_name + length - 4, ".txt") == 0 && strcmp(entry->d_name, "instructions.txt") != 0 &&
+                programNumber(entry->d_name) == -1) {
+                result = addBatchPath(paths, count, &capacity, path, entry->d_name);
+            }
+        }
+        closedir(dir);
+        if (result == 0) {
+            qsort(*paths, *count, sizeof(char *), comparePaths);
+        }
+    } else {
+        FILE *manifest = fopen(path, "r");
+        if (manifest == NULL) {
+            fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        // entries are relative to the directory of the manifest
+        char directory[4096];
+        const char *slash = strrchr(path, '/');
+        int directoryLength = slash == NULL ? 0 : (int)(slash - path);
+        snprintf(directory, sizeof(directory), "%.*s", directoryLength, path);
+
+        char *line = NULL;
+        size_t lineCapacity = 0;
+        ssize_t length;
+        while (result == 0 && (length = getline(&line, &lineCapacity, manifest)) != -1) {
+            while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t')) {
+                line[--length] = '\0';
+            }
+            const char *entry = line;
+            while (*entry == ' ' || *entry == '\t') {
+                entry++;
+            }
+            if (*entry != '\0' && *entry != '#') {
+                result = addBatchPath(paths, count, &capacity, directory, entry);
+            }
+        }
+        free(line);
+        fclose(manifest);
+    }
+
+    if (result == -1) {
+        for (int b = 0; b < *count; b++) {
+            free((*paths)[b]);
+        }
+        free(*paths);
+        *paths = NULL;
+        *count = 0;
+    }
+    return result;
+}
+
+// Function to write one export of a recorded run to path
+static int exportRecording(const char *path, int (*writer)(FILE *, const EventRecorder *), const EventRecorder *recorder) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int result = writer(file, recorder);
+    if (fclose(file) != 0) {
+        result = -1;
+    }
+    if (result == -1) {
+        fprintf(stderr, "Error writing %s\n", path);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    static const char *const sweepOptions[SWEEP_PARAMETERS] = {
+        "--silver-quantum", "--gold-quantum", "--context-switch", "--silver-to-gold", "--gold-to-platinum",
+        "--cpus", "--migration-cost", "--policy"
+    };
+    const char *directory = NULL;
+    const char *tracePath = NULL;
+    const char *convertPath = NULL;
+    const char *outputPath = NULL;
+    const char *streamPath = NULL;
+    const char *batchPath = NULL;
+    const char *eventsPath = NULL;
+    const char *metricsPath = NULL;
+    const char *chromeTracePath = NULL;
+    const char *generatePath = NULL;
+    const char *goldenRecordPath = NULL;
+    const char *goldenCheckPath = NULL;
+    int fuzzCases = 0;
+    int benchmark = 0;
+    IntList benchSizes = {0};
+    int balance = BALANCE_GLOBAL;
+    PolicyConfig defaults;
+    int deadlines[3];
+    ReplicationConfig replication;
+    int replicate = 0;
+    GeneratorConfig generator;
+    IntList lists[SWEEP_PARAMETERS];
+    int sweep = 0;
+    int printStats = 0;
+    int profile = 0;
+    const char *checkpointPrefix = "checkpoint";
+    int checkpointInterval = 0;
+    const char *resumePath = NULL;
+    long numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(lists, 0, sizeof(lists));
+    defaultPolicyConfig(&defaults);
+    memcpy(deadlines, defaults.deadlines, sizeof(deadlines));
+    defaultGeneratorConfig(&generator);
+    defaultReplicationConfig(&replication);
+
+    for (int i = 1; i < argc; i++) {
+        int generatorOption = parseGeneratorOption(argc, argv, &i, &generator);
+        if (generatorOption == -1) {
+            return 1;
+        }
+        if (generatorOption == 1) {
+            continue;
+        }
+
+        int option = -1;
+        for (int p = 0; p < SWEEP_PARAMETERS; p++) {
+            if (strcmp(argv[i], sweepOptions[p]) == 0) {
+                option = p;
+            }
+        }
+
+        if (option != -1 && i + 1 < argc) {
+            i++;
+            if ((option == SWEEP_POLICY ? parsePolicyList(argv[i], &lists[option]) : parseIntList(argv[i], &lists[option])) == -1) {
+                return 1;
+            }
+            if (lists[option].count > 1) {
+                sweep = 1;
+            }
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc) {
+            convertPath = argv[++i];
+        } else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            streamPath = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (strcmp(argv[i], "--replications") == 0 && i + 1 < argc) {
+            if (parseCountOption("--replications", argv[++i], 1, &replication.replications) == -1) {
+                return 1;
+            }
+            replicate = 1;
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            if (parseCountOption("--jitter", argv[++i], 0, &replication.arrival_jitter) == -1) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--length-variation") == 0 && i + 1 < argc) {
+            if (parseRatioOption("--length-variation", argv[++i], &replication.length_variation) == -1) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--deadlines") == 0 && i + 1 < argc) {
+            IntList values = {0};
+            if (parseIntList(argv[++i], &values) == -1 || values.count != 3 ||
+                values.values[0] == 0 || values.values[1] == 0 || values.values[2] == 0) {
+                fprintf(stderr, "--deadlines expects three positive values: PLATINUM,GOLD,SILVER\n");
+                free(values.values);
+                return 1;
+            }
+            memcpy(deadlines, values.values, sizeof(deadlines));
+            free(values.values);
+        } else if (strcmp(argv[i], "--balance") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "global") == 0) {
+                balance = BALANCE_GLOBAL;
+            } else if (strcmp(argv[i], "steal") == 0) {
+                balance = BALANCE_STEAL;
+            } else if (strcmp(argv[i], "affinity") == 0) {
+                balance = BALANCE_AFFINITY;
+            } else {
+                fprintf(stderr, "Unknown balancing %s, expected global, steal or affinity\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generatePath = argv[++i];
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            benchmark = 1;
+        } else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc) {
+            if (parseCountOption("--fuzz", argv[++i], 1, &fuzzCases) == -1) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--golden-record") == 0 && i + 1 < argc) {
+            goldenRecordPath = argv[++i];
+        } else if (strcmp(argv[i], "--golden-check") == 0 && i + 1 < argc) {
+            goldenCheckPath = argv[++i];
+        } else if (strcmp(argv[i], "--bench-sizes") == 0 && i + 1 < argc) {
+            free(benchSizes.values);
+            memset(&benchSizes, 0, sizeof(benchSizes));
+            if (parseIntList(argv[++i], &benchSizes) == -1) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            eventsPath = argv[++i];
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (strcmp(argv[i], "--chrome-trace") == 0 && i + 1 < argc) {
+            chromeTracePath = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            printStats = 1;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = 1;
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            if (parseCountOption("--checkpoint-every", argv[++i], 1, &checkpointInterval) == -1) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--checkpoint-prefix") == 0 && i + 1 < argc) {
+            checkpointPrefix = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resumePath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            int threads;
+            if (parseCountOption("--threads", argv[++i], 1, &threads) == -1) {
+                return 1;
+            }
+            numThreads = threads;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    PolicyConfig *configs = NULL;
+    int numConfigs = buildPolicyGrid(lists, &configs);
+    for (int p = 0; p < SWEEP_PARAMETERS; p++) {
+        free(lists[p].values);
+    }
+    if (numConfigs == -1) {
+        return 1;
+    }
+    for (int c = 0; c < numConfigs; c++) {
+        configs[c].balance = balance;
+        memcpy(configs[c].deadlines, deadlines, sizeof(deadlines));
+    }
+    if (streamPath != NULL && (sweep || tracePath != NULL || convertPath != NULL)) {
+        fprintf(stderr, "--stream cannot be combined with --sweep, --trace or --convert\n");
+        free(configs);
+        return 1;
+    }
+    if (batchPath != NULL && (streamPath != NULL || sweep || tracePath != NULL || convertPath != NULL || replicate ||
+                              profile || checkpointInterval > 0 || resumePath != NULL)) {
+        fprintf(stderr, "--batch cannot be combined with --stream, --sweep, --trace, --convert, --replications, --profile or checkpoints\n");
+        free(configs);
+        return 1;
+    }
+    int recording = eventsPath != NULL || metricsPath != NULL || chromeTracePath != NULL ||
+                    goldenRecordPath != NULL || goldenCheckPath != NULL;
+    if (replicate && (sweep || recording || streamPath != NULL || convertPath != NULL)) {
+        fprintf(stderr, "--replications cannot be combined with --sweep, --stream, --convert or event recording\n");
+        free(configs);
+        return 1;
+    }
+    replication.seed = generator.seed;
+    if (profile && (sweep || replicate || convertPath != NULL || benchmark || generatePath != NULL)) {
+        fprintf(stderr, "--profile applies to single and streamed runs only\n");
+        free(configs);
+        return 1;
+    }
+    if ((checkpointInterval > 0 || resumePath != NULL) && (sweep || replicate || convertPath != NULL || benchmark || generatePath != NULL)) {
+        fprintf(stderr, "--checkpoint-every and --resume apply to single and streamed runs only\n");
+        free(configs);
+        return 1;
+    }
+    if (recording && (sweep || batchPath != NULL)) {
+        fprintf(stderr, "--events, --metrics, --chrome-trace and --golden-* record a single run and cannot be combined with --sweep or --batch\n");
+        free(configs);
+        return 1;
+    }
+
+    if (benchmark || generatePath != NULL || fuzzCases > 0) {
+        int status = 0;
+        if (sweep || recording || streamPath != NULL || batchPath != NULL || tracePath != NULL || convertPath != NULL ||
+            (benchmark != 0) + (generatePath != NULL) + (fuzzCases > 0) > 1) {
+            fprintf(stderr, "--bench, --generate and --fuzz run on their own and cannot be combined with other modes\n");
+            status = 1;
+        } else if (fuzzCases > 0) {
+            // exit status 1 on any mismatch, so the harness can gate changes to the engine
+            status = runFuzz(stdout, generator.seed, fuzzCases) != 0 ? 1 : 0;
+        } else if (generatePath != NULL) {
+            Workload generated;
+            if (generateWorkload(&generator, &generated) == -1) {
+                status = 1;
+            } else {
+                status = writeTextWorkload(generatePath, &generated) == -1 ? 1 : 0;
+                freeWorkload(&generated);
+            }
+        } else {
+            static const int defaultSizes[] = {10, 100, 1000, 10000, 100000, 1000000, 10000000};
+            IntList sizes = benchSizes;
+            if (sizes.count == 0) {
+                sizes.values = (int *)defaultSizes;
+                sizes.count = sizeof(defaultSizes) / sizeof(defaultSizes[0]);
+            }
+
+            FILE *output = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+            if (output == NULL) {
+                fprintf(stderr, "Error opening the output file %s: %s\n", outputPath, strerror(errno));
+                status = 1;
+            } else {
+                status = runBenchmark(output, &generator, &configs[0], &sizes) == -1 ? 1 : 0;
+                if (output != stdout && fclose(output) != 0) {
+                    fprintf(stderr, "Error writing the output file %s\n", outputPath);
+                    status = 1;
+                }
+            }
+        }
+        free(benchSizes.values);
+        free(configs);
+        return status;
+    }
+    free(benchSizes.values);
+
+    Workload workload;
+    int loaded;
+    if (streamPath != NULL || batchPath != NULL) {
+        loaded = loadProgramLibrary(directory, &workload, (int)numThreads);
+    } else if (tracePath != NULL) {
+        loaded = loadTraceFile(tracePath, &workload);
+    } else {
+        loaded = loadTextWorkload(directory, &workload, (int)numThreads);
+    }
+    if (loaded == -1) {
+        free(configs);
+        return 1;
+    }
+
+    if (convertPath != NULL) {
+        int written = writeTraceFile(convertPath, &workload);
+        freeWorkload(&workload);
+        free(configs);
+        return written == -1 ? 1 : 0;
+    }
+
+    FILE *output = stdout;
+    if (outputPath != NULL) {
+        output = fopen(outputPath, "w");
+        if (output == NULL) {
+            fprintf(stderr, "Error opening the output file %s: %s\n", outputPath, strerror(errno));
+            freeWorkload(&workload);
+            free(configs);
+            return 1;
+        }
+    }
+
+    int status = 0;
+    EventRecorder *recorder = NULL;
+    if (recording && (recorder = createEventRecorder()) == NULL) {
+        perror("Error allocating the event log");
+        status = 1;
+    } else if (streamPath != NULL) {
+        FILE *input = strcmp(streamPath, "-") == 0 ? stdin : fopen(streamPath, "r");
+        SchedulerContext *context = createSchedulerContext();
+        ScheduleResults results = {0};
+
+        if (context != NULL) {
+            setEventRecorder(context, recorder);
+            setCheckpointing(context, checkpointPrefix, checkpointInterval);
+        }
+        double start = monotonicMs();
+        if (input == NULL) {
+            fprintf(stderr, "Error opening the stream %s: %s\n", streamPath, strerror(errno));
+            status = 1;
+        } else if (context == NULL ||
+                   (resumePath != NULL ? resumeStream(context, &workload, input, streamPath, resumePath, &configs[0], &results)
+                                       : scheduleStream(context, &workload, input, streamPath, &configs[0], &results)) == -1) {
+            status = 1;
+        } else {
+            // streamed definitions are read while scheduling
+            double scheduleMs = monotonicMs() - start;
+            start = monotonicMs();
+            printAverages(output, &results.averages);
+            if (results.num_cores > 0) {
+                printCoreStats(output, &results);
+            }
+            if (printStats) {
+                printScheduleStats(output, &results);
+            }
+            if (profile) {
+                printProfile(output, &workload, scheduleMs, monotonicMs() - start, &results);
+            }
+        }
+        if (input != NULL && input != stdin) {
+            fclose(input);
+        }
+        freeScheduleResults(&results);
+        destroySchedulerContext(context);
+    } else if (batchPath != NULL) {
+        char **paths;
+        int numPaths;
+        if (listBatchFiles(batchPath, &paths, &numPaths) == -1) {
+            status = 1;
+        } else {
+            BatchResult *results = malloc((numPaths > 0 ? numPaths : 1) * sizeof(BatchResult));
+            if (results == NULL) {
+                perror("Error allocating the batch");
+                status = 1;
+            } else {
+                // failed files are reported in the table and fail the run, the others still count
+                if (runBatch(&workload, (const char *const *)paths, numPaths, &configs[0], results, (int)numThreads) == -1) {
+                    status = 1;
+                }
+                printBatchTable(output, (const char *const *)paths, results, numPaths);
+            }
+            free(results);
+            for (int b = 0; b < numPaths; b++) {
+                free(paths[b]);
+            }
+            free(paths);
+        }
+    } else if (replicate) {
+        ReplicationSummary summary;
+        if (runReplications(&workload, &configs[0], &replication, (int)numThreads, &summary) == -1) {
+            status = 1;
+        } else {
+            printReplicationSummary(output, &summary);
+        }
+    } else if (sweep) {
+        ScheduleAverages *results = malloc(numConfigs * sizeof(ScheduleAverages));
+        if (results == NULL || runSweep(&workload, configs, numConfigs, results, (int)numThreads) == -1) {
+            status = 1;
+        } else {
+            printSweepTable(output, configs, results, numConfigs);
+        }
+        free(results);
+    } else {
+        SchedulerContext *context = createSchedulerContext();
+        ScheduleResults results = {0};
+
+        if (context != NULL) {
+            setEventRecorder(context, recorder);
+            setCheckpointing(context, checkpointPrefix, checkpointInterval);
+        }
+        // Perform preemptive priority scheduling
+        double start = monotonicMs();
+        if (context == NULL ||
+            (resumePath != NULL ? resumeWorkload(context, &workload, resumePath, &configs[0], &results)
+                                : scheduleWorkload(context, &workload, &configs[0], &results)) == -1) {
+            status = 1;
+        } else {
+            double scheduleMs = monotonicMs() - start;
+            start = monotonicMs();
+            // Print average waiting time and average turnaround time
+            printAverages(output, &results.averages);
+            if (results.num_cores > 0) {
+                printCoreStats(output, &results);
+            }
+            if (printStats) {
+                printScheduleStats(output, &results);
+            }
+            if (profile) {
+                printProfile(output, &workload, scheduleMs, monotonicMs() - start, &results);
+            }
+        }
+        freeScheduleResults(&results);
+        destroySchedulerContext(context);
+    }
+
+    if (status == 0 && recorder != NULL) {
+        if ((eventsPath != NULL && exportRecording(eventsPath, writeEventsCsv, recorder) == -1) ||
+            (metricsPath != NULL && exportRecording(metricsPath, writeProcessMetricsCsv, recorder) == -1) ||
+            (chromeTracePath != NULL && exportRecording(chromeTracePath, writeChromeTrace, recorder) == -1) ||
+            (goldenRecordPath != NULL && exportRecording(goldenRecordPath, writeGolden, recorder) == -1) ||
+            (goldenCheckPath != NULL && checkGolden(goldenCheckPath, recorder) != 0)) {
+            status = 1;
+        }
+    }
+    destroyEventRecorder(recorder);
+
+    if (output != stdout && fclose(output) != 0) {
+        fprintf(stderr, "Error writing the output file %s\n", outputPath);
+        status = 1;
+    }
+    freeWorkload(&workload);
+    free(configs);
+    return status;
+}
+#endif
@@ -0,0 +1,318 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Preemptive priority scheduler simulation as a library.
+ * Compile scheduler.c with -DSCHEDULER_NO_MAIN to embed it without the command line tool.
+ *
+ * A Workload is loaded once and only read by scheduleWorkload, so any number of threads may
+ * schedule the same workload at the same time as long as each one uses its own
+ * SchedulerContext and ScheduleResults. Nothing in the library uses global state.
+ */
+
+// The process structure
+// Type enumeration: 1 for plat, 2 for gold, 3 for silver
+typedef struct {
+    int id;
+    int priority;
+    int arrival_time;
+    int remaining_time;
+    int burst_time;
+    int instruction_index;
+    int type;
+    int completed;  // Flag to indicate whether the process is completed
+    int instruction_offset;  // First instruction id of the process in the shared InstructionPool
+    int instruction_count;
+    int input_index;       // position of the definition in its input
+    int first_run;         // time of the first dispatch, -1 before it
+    int context_switches;  // context switches paid to run this process
+    int preemptions;
+    int original_type;     // type at arrival, before any promotion
+    int ready_time;        // time the process last became ready
+    int last_cpu;          // CPU of the last slice, -1 before the first
+    long long vruntime;    // POLICY_CFS: execution time weighted by priority
+} Process;
+
+// Growable table of processes; capacity doubles so n appends cost O(n) copies in total
+typedef struct {
+    Process *items;
+    int count;
+    int capacity;
+} ProcessTable;
+
+// Instruction ids of every program, stored back to back and referenced by offset and length
+// Each program ends with the exit instruction (id -1)
+// burst_prefix[offset + k] is the burst time of instructions 0..k of that program
+typedef struct {
+    int *ids;
+    int *burst_prefix;
+    int count;
+    int capacity;
+} InstructionPool;
+
+// A whole input file mapped read-only into memory
+typedef struct {
+    const char *data;
+    size_t size;
+    int mapped;
+} MappedFile;
+
+// Loading phases timed by the loaders
+enum { LOAD_INSTRUCTIONS, LOAD_PROGRAMS, LOAD_DEFINITIONS, LOAD_TRACE, LOAD_PHASES };
+
+// Everything a scheduling run reads: programs (PX.txt at index X-1), definitions and the instruction pool
+typedef struct {
+    Process *programs;
+    int num_programs;
+    ProcessTable definitions;
+    InstructionPool pool;
+    MappedFile trace;  // backing storage of the pool when loaded from a binary trace
+    double load_ms[LOAD_PHASES];  // wall-clock time of each loading phase, 0 for phases not run
+} Workload;
+
+// Load balancing of multi-CPU runs: one shared queue, per-CPU queues with work stealing,
+// or per-CPU queues with program X pinned to CPU (X-1) mod num_cpus
+enum { BALANCE_GLOBAL, BALANCE_STEAL, BALANCE_AFFINITY };
+
+// Scheduling policies
+// POLICY_TIERED: platinum runs to completion, gold and silver round robin by priority and age upwards
+// POLICY_MLFQ: three levels with quantum q, 2q and 4q (q = silver_quantum); a process drops a level
+//              once it has used the level's allotment, arrivals preempt lower levels
+// POLICY_CFS: lowest weighted virtual runtime first, slices of gold_quantum, weight = priority
+// POLICY_EDF: earliest arrival + deadlines[type - 1] first, preemptive
+enum { POLICY_TIERED, POLICY_MLFQ, POLICY_CFS, POLICY_EDF };
+
+// Scheduling policy constants, all times in ms
+typedef struct {
+    int silver_quantum;
+    int gold_quantum;
+    int context_switch;
+    int silver_to_gold_threshold;    // execution time after which silver becomes gold
+    int gold_to_platinum_threshold;  // execution time after which gold becomes platinum
+    int num_cpus;
+    int migration_cost;              // paid on top of the context switch when a process changes CPU
+    int balance;                     // BALANCE_GLOBAL, BALANCE_STEAL or BALANCE_AFFINITY
+    int policy;                      // POLICY_TIERED by default
+    int deadlines[3];                // completion deadline after arrival per type, ordering EDF and counted as misses
+} PolicyConfig;
+
+// Averages of one scheduling run
+typedef struct {
+    double avg_waiting;
+    double avg_turnaround;
+    double avg_response;
+    double throughput;           // completions per simulated second
+    double deadline_miss_rate;   // share of processes completed after their deadline
+} ScheduleAverages;
+
+// Statistics of one CPU of a multi-CPU run; tiers are indexed by original type - 1
+typedef struct {
+    long long busy_time;             // ms running slices
+    long long switch_time;           // ms of context switches and migrations
+    long migrations;                 // dispatches of processes that last ran on another CPU
+    long long tier_waiting[3];       // ms waited before dispatches on this CPU, switch and migration included
+    long tier_dispatches[3];
+    int tier_max_waiting[3];
+} CoreStats;
+
+// Running statistics of one metric in constant memory; any number of them can be merged
+// buckets is a log-linear histogram: exact below 128, then 64 buckets per power of two
+#define HISTOGRAM_BUCKETS 1664
+
+typedef struct {
+    long count;
+    long long sum;
+    int min;
+    int max;
+    double mean;
+    double m2;                       // sum of squared deviations from the mean (Welford)
+    long buckets[HISTOGRAM_BUCKETS];
+} MetricStats;
+
+typedef struct {
+    MetricStats waiting;
+    MetricStats turnaround;
+    MetricStats response;
+} ScheduleStats;
+
+// Hot-path counters of one run; all zero when scheduler.c is compiled with -DSCHEDULER_NO_PROFILE
+typedef struct {
+    long loop_iterations;
+    long dispatch_decisions;      // ready queue selections, including those that found it empty
+    long queue_pushes;
+    long queue_pops;
+    long context_switches;
+    long long switch_time;        // ms charged for context switches and migrations
+    long long switch_delay;       // turnaround ms they add: each switch delays every process waiting behind it
+                                  // (exact on one CPU, an upper bound with a shared multi-CPU queue)
+    long preemptions;
+    long platinum_preemptions;    // slices cut short by a platinum arrival
+    long promotions;
+    long idle_jumps;
+    long long idle_skipped;       // ms the clock jumped over with every CPU idle
+} ProfileCounters;
+
+// Result of one scheduling run; zero-initialize before first use, buffers are reused between runs
+typedef struct {
+    int per_process;        // set to keep the per-definition arrays below (batch runs only)
+    int *turnaround_times;  // per definition, in definition order
+    int *waiting_times;
+    int num_processes;
+    int capacity;
+    long num_completed;
+    long long total_turnaround;
+    long long total_waiting;
+    long long total_response;      // first dispatch - arrival, summed
+    long total_context_switches;
+    long num_dispatches;           // CPU slices
+    int peak_live;  // most processes admitted and not yet completed at once
+    CoreStats *cores;  // per CPU, multi-CPU runs only (num_cores is 0 otherwise)
+    int num_cores;
+    int cores_capacity;
+    long migrations;
+    int makespan;                  // time of the last completion
+    long deadline_misses;
+    ScheduleStats *type_stats;  // 9 groups, [original type - 1][final type - 1]
+    ProfileCounters profile;
+    ScheduleAverages averages;
+} ScheduleResults;
+
+// Synthetic workload generator settings, see defaultGeneratorConfig
+enum { ARRIVAL_POISSON, ARRIVAL_BURSTY };
+enum { LENGTH_UNIFORM, LENGTH_EXPONENTIAL };
+
+typedef struct {
+    unsigned long long seed;
+    int num_processes;
+    int num_programs;            // definitions pick P1..P<num_programs> uniformly
+    int arrival_pattern;         // ARRIVAL_POISSON or ARRIVAL_BURSTY
+    double mean_interarrival;    // ms between arrivals on average, for both patterns
+    int burst_size;              // arrivals at the same instant for ARRIVAL_BURSTY
+    int type_mix[3];             // relative weights of platinum, gold and silver
+    int max_priority;            // priorities are uniform in 1..max_priority
+    int num_instructions;        // distinct instruction ids
+    int length_distribution;     // of instruction lengths: LENGTH_UNIFORM or LENGTH_EXPONENTIAL
+    int mean_instruction_length; // ms
+    int mean_program_length;     // instructions before exit, uniform in 1..2*mean-1
+} GeneratorConfig;
+
+// Randomization of Monte Carlo replications of a loaded workload
+typedef struct {
+    int replications;
+    unsigned long long seed;     // replication r draws from its own stream derived from seed and r
+    int arrival_jitter;          // ms, arrivals move uniformly within +-jitter
+    double length_variation;     // instruction lengths scale uniformly within 1 +- variation (0 <= variation < 1)
+} ReplicationConfig;
+
+// One metric over all replications
+typedef struct {
+    double mean;
+    double ci_low;               // 95% confidence interval of the mean (Student's t)
+    double ci_high;
+    double stddev;
+    double min;
+    double max;
+} MetricSummary;
+
+// Average, p50, p95 and p99 of waiting and turnaround time, each summarized over the replications
+typedef struct {
+    int replications;
+    MetricSummary waiting[4];
+    MetricSummary turnaround[4];
+} ReplicationSummary;
+
+// Scratch state of one scheduling thread (working copy of the processes, ready queue, ...)
+typedef struct SchedulerContext SchedulerContext;
+
+// Optional log of the scheduling events and per-process metrics of the runs of one context
+// Memory is kept between runs; each run starts a fresh log
+typedef struct EventRecorder EventRecorder;
+
+// Loading; directory may be NULL for the current directory. Return 0 on success, -1 on failure
+// The PX.txt files of a directory are read and parsed on num_threads threads
+int loadTextWorkload(const char *directory, Workload *workload, int num_threads);
+int loadTraceFile(const char *filename, Workload *workload);
+// Program library: instructions.txt and every PX.txt in directory, no definitions
+int loadProgramLibrary(const char *directory, Workload *workload, int num_threads);
+int writeTraceFile(const char *filename, const Workload *workload);
+// Writes instructions.txt, definition.txt and the PX.txt files into an existing directory
+int writeTextWorkload(const char *directory, const Workload *workload);
+void freeWorkload(Workload *workload);
+
+void defaultPolicyConfig(PolicyConfig *config);
+// Name of a POLICY_ value, and the value of a name (-1 when unknown)
+const char *policyName(int policy);
+int policyByName(const char *name);
+
+void defaultGeneratorConfig(GeneratorConfig *config);
+// The same settings and seed always generate the same workload
+int generateWorkload(const GeneratorConfig *config, Workload *workload);
+
+SchedulerContext *createSchedulerContext(void);
+void destroySchedulerContext(SchedulerContext *context);
+
+// Schedule the workload under config; the workload is not modified. Returns 0 on success, -1 on failure
+int scheduleWorkload(SchedulerContext *context, const Workload *workload, const PolicyConfig *config, ScheduleResults *results);
+void freeScheduleResults(ScheduleResults *results);
+
+// Statistics; a type of 0 matches every type
+void resetMetricStats(MetricStats *stats);
+void addMetricSample(MetricStats *stats, int value);
+void mergeMetricStats(MetricStats *into, const MetricStats *from);
+double metricStddev(const MetricStats *stats);
+// Nearest-rank percentile, p in 0..1; exact below 128, within 0.8% above
+double metricPercentile(const MetricStats *stats, double p);
+void collectScheduleStats(const ScheduleResults *results, int originalType, int finalType, ScheduleStats *stats);
+void printScheduleStats(FILE *stream, const ScheduleResults *results);
+// Phase timings (LOAD_ phases, then schedule and report ms) and the hot-path counters of a run
+void printProfile(FILE *stream, const Workload *workload, double scheduleMs, double reportMs, const ScheduleResults *results);
+
+// Event recording; attach with setEventRecorder(context, NULL) to stop recording
+EventRecorder *createEventRecorder(void);
+void destroyEventRecorder(EventRecorder *recorder);
+void setEventRecorder(SchedulerContext *context, EventRecorder *recorder);
+// Exports of the last recorded run. Return 0 on success, -1 on write errors
+int writeEventsCsv(FILE *stream, const EventRecorder *recorder);
+int writeProcessMetricsCsv(FILE *stream, const EventRecorder *recorder);
+int writeChromeTrace(FILE *stream, const EventRecorder *recorder);
+
+// Schedule definitions read line by line from input (definition.txt format, non-decreasing arrival times)
+// against the programs of library; only live processes are kept, results hold totals and averages only
+int scheduleStream(SchedulerContext *context, const Workload *library, FILE *input, const char *name,
+                   const PolicyConfig *config, ScheduleResults *results);
+
+// Checkpointing: every interval simulated ms, runs of context write a snapshot of their whole state
+// to <prefix>-<time>.ckpt from a background thread; a NULL prefix or interval of 0 turns it off
+// Streamed runs need a seekable input
+void setCheckpointing(SchedulerContext *context, const char *prefix, int interval);
+// Continue a run from a snapshot taken of the same workload or stream with the same CPU count and
+// balancing; the rest of config may differ to fork the run under other settings
+int resumeWorkload(SchedulerContext *context, const Workload *workload, const char *snapshot,
+                   const PolicyConfig *config, ScheduleResults *results);
+int resumeStream(SchedulerContext *context, const Workload *library, FILE *input, const char *name, const char *snapshot,
+                 const PolicyConfig *config, ScheduleResults *results);
+
+// Schedule one workload under every configuration on num_threads threads
+int runSweep(const Workload *workload, const PolicyConfig configs[], int num_configs, ScheduleAverages results[], int num_threads);
+
+// Result of one definition file of a batch
+typedef struct {
+    int failed;            // the file could not be read or scheduled, see the messages on standard error
+    int num_processes;
+    ScheduleAverages averages;
+} BatchResult;
+
+// Schedule every definition file of paths against the programs of library (see loadProgramLibrary)
+// on num_threads threads. Returns 0 when every file was scheduled, -1 when any failed
+int runBatch(const Workload *library, const char *const paths[], int num_paths, const PolicyConfig *config,
+             BatchResult results[], int num_threads);
+
+// Schedule config->replications randomized copies of workload on num_threads threads and summarize them
+void defaultReplicationConfig(ReplicationConfig *config);
+int runReplications(const Workload *workload, const PolicyConfig *policy, const ReplicationConfig *config,
+                    int num_threads, ReplicationSummary *summary);
+
+#endif
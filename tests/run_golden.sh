@@ -0,0 +1,43 @@
+#!/bin/sh
+# Regression check for the scheduler: every case under tests/golden must reproduce its
+# expected.golden exactly, and a fixed-seed fuzz run must agree with the reference engine.
+# Exits non-zero on the first build failure and after any mismatch.
+#
+# Usage: tests/run_golden.sh [--record]
+#   --record   rewrite every expected.golden from the current build instead of checking
+#   SCHED=PATH use an already built scheduler instead of compiling scheduler.c
+#   FUZZ_CASES=N, FUZZ_SEED=S  size and seed of the fuzz run (default 500 cases, seed 1)
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+record=0
+if [ "$1" = "--record" ]; then
+    record=1
+fi
+
+sched=${SCHED:-}
+if [ -z "$sched" ]; then
+    build=$(mktemp -d "${TMPDIR:-/tmp}/schedgolden-XXXXXX") || exit 1
+    trap 'rm -rf "$build"' EXIT
+    sched=$build/scheduler
+    ${CC:-cc} -O2 -pthread -o "$sched" "$root/scheduler.c" -lm || exit 1
+fi
+
+status=0
+for dir in "$root"/tests/golden/*/; do
+    case=${dir%/}
+    name=$(basename "$case")
+    if [ $record -eq 1 ]; then
+        "$sched" --dir "$case" --golden-record "$case/expected.golden" > /dev/null || status=1
+        echo "recorded $name"
+    elif "$sched" --dir "$case" --golden-check "$case/expected.golden" > /dev/null; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        status=1
+    fi
+done
+
+if [ $record -eq 0 ]; then
+    "$sched" --fuzz "${FUZZ_CASES:-500}" --seed "${FUZZ_SEED:-1}" || status=1
+fi
+exit $status